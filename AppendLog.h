@@ -0,0 +1,331 @@
+// --------------------------
+// projects/deque/AppendLog.h
+// --------------------------
+
+#ifndef AppendLog_h
+#define AppendLog_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // copy, fill
+#include <atomic>    // atomic
+#include <cassert>   // assert
+#include <cstddef>   // ptrdiff_t, size_t
+#include <iterator>  // forward_iterator_tag
+#include <memory>    // allocator, allocator_traits
+#include <stdexcept> // length_error
+#include <stdint.h>  // uint64_t
+
+#include "Deque.h"
+
+// ---------
+// AppendLog
+// ---------
+
+/**
+ a deque that one writer thread appends to while any number of reader threads
+ index and iterate, without a lock
+ elements live in inner arrays that never move; the writer constructs an
+ element, then publishes the new size with a release store, and a reader sees
+ [0, size) as of its acquire load
+ the outer array does move when it fills: the writer publishes a copy twice the
+ size and retires the old one, which is given back once no reader can still be
+ looking at it (epoch-based reclamation: a reader announces the epoch it read
+ the outer array in, and an outer array retired in epoch e goes once every
+ announced epoch is later than e)
+ readers go through a Reader, one per thread, and a View, which pins the
+ outer array for as long as it lives; inside a View, reads are wait-free
+ */
+template <typename T, typename A = std::allocator<T> >
+class AppendLog {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef A                                                           allocator_type;
+        typedef std::allocator_traits<A>                                    alloc_traits;
+        typedef T                                                           value_type;
+        typedef std::size_t                                                 size_type;
+        typedef typename alloc_traits::pointer                              pointer;
+        typedef typename alloc_traits::template rebind_alloc<pointer>       map_allocator_type;
+        typedef std::allocator_traits<map_allocator_type>                   map_traits;
+
+        static const size_type blockShift = 10;                             // log2 of blockSize
+        static const size_type blockSize  = size_type(1) << blockShift;     // elements per inner array
+        static const size_type maxReaders = 64;
+
+    private:
+        // -----
+        // types
+        // -----
+
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> epoch;    // the epoch a View of this reader started in, 0 if none
+            std::atomic<bool>     used;};   // a Reader holds this slot
+
+        struct Retired {
+            pointer*  map;
+            size_type capacity;
+            uint64_t  epoch;};              // the epoch it was retired in
+
+        // ----
+        // data
+        // ----
+
+        allocator_type          _a;
+        map_allocator_type      _ma;
+        std::atomic<pointer*>   _map;       // the outer array readers load
+        size_type               _capacity;  // of _map, writer only
+        size_type               _blocks;    // inner arrays in _map, writer only
+        std::atomic<size_type>  _size;      // published elements
+        std::atomic<uint64_t>   _epoch;
+        MyDeque<Retired>        _retired;   // writer only
+        Slot                    _slots[maxReaders];
+
+        AppendLog (const AppendLog&);
+        AppendLog& operator = (const AppendLog&);
+
+        // -------
+        // reclaim
+        // -------
+
+        /**
+         gives back the retired outer arrays no reader can be using
+         */
+        void reclaim () {
+            uint64_t oldest = _epoch.load();
+            for (size_type i = 0; i != maxReaders; ++i) {
+                const uint64_t e = _slots[i].epoch.load();
+                if (e && (e < oldest))
+                    oldest = e;}
+            while (!_retired.empty() && (_retired.front().epoch < oldest)) {
+                map_traits::deallocate(_ma, _retired.front().map, _retired.front().capacity);
+                _retired.pop_front();}}
+
+        // ----
+        // grow
+        // ----
+
+        /**
+         publishes an outer array twice the size and retires the old one
+         */
+        void grow () {
+            pointer*        old = _map.load(std::memory_order_relaxed);
+            const size_type cap = 2 * _capacity;
+            pointer*        m   = map_traits::allocate(_ma, cap);
+            std::copy(old, old + _blocks, m);
+            std::fill(m + _blocks, m + cap, pointer());
+            _map.store(m);
+            const Retired r = {old, _capacity, _epoch.fetch_add(1)};
+            _retired.push_back(r);
+            _capacity = cap;
+            reclaim();}
+
+    public:
+        // ----
+        // View
+        // ----
+
+        /**
+         the first size() elements as of when it was made, pinned until it's destroyed
+         */
+        class View {
+            friend class AppendLog;
+
+            private:
+                Slot*           _s;
+                const pointer*  _m;
+                size_type       _n;
+
+                View (AppendLog& l, Slot* s) :
+                        _s (s) {
+                    assert(!_s->epoch.load(std::memory_order_relaxed));
+                    _s->epoch.store(l._epoch.load());
+                    _n = l._size.load(std::memory_order_acquire);
+                    _m = l._map.load();}
+
+                View (const View&);
+                View& operator = (const View&);
+
+            public:
+                class const_iterator {
+                    friend class View;
+
+                    public:
+                        typedef std::forward_iterator_tag       iterator_category;
+                        typedef T                               value_type;
+                        typedef std::ptrdiff_t                  difference_type;
+                        typedef const T*                        pointer;
+                        typedef const T&                        reference;
+
+                    private:
+                        const View* _v;
+                        size_type   _i;
+
+                        const_iterator (const View* v, size_type i) :
+                                _v (v),
+                                _i (i)
+                            {}
+
+                    public:
+                        friend bool operator == (const const_iterator& lhs, const const_iterator& rhs) {
+                            return lhs._i == rhs._i;}
+
+                        friend bool operator != (const const_iterator& lhs, const const_iterator& rhs) {
+                            return !(lhs == rhs);}
+
+                        friend difference_type operator - (const const_iterator& lhs, const const_iterator& rhs) {
+                            return difference_type(lhs._i) - difference_type(rhs._i);}
+
+                        reference operator * () const {
+                            return (*_v)[_i];}
+
+                        pointer operator -> () const {
+                            return &**this;}
+
+                        const_iterator& operator ++ () {
+                            ++_i;
+                            return *this;}
+
+                        const_iterator& operator += (difference_type d) {
+                            _i += d;
+                            return *this;}};
+
+                ~View () {
+                    _s->epoch.store(0, std::memory_order_release);}
+
+                const T& operator [] (size_type i) const {
+                    assert(i < _n);
+                    return _m[i >> blockShift][i & (blockSize - 1)];}
+
+                size_type size () const {
+                    return _n;}
+
+                const_iterator begin () const {
+                    return const_iterator(this, 0);}
+
+                const_iterator end () const {
+                    return const_iterator(this, _n);}};
+
+        // ------
+        // Reader
+        // ------
+
+        /**
+         a reader thread's registration, one of at most maxReaders at a time
+         */
+        class Reader {
+            private:
+                AppendLog&  _l;
+                Slot*       _s;
+
+                Reader (const Reader&);
+                Reader& operator = (const Reader&);
+
+            public:
+                /**
+                 throws length_error if maxReaders are already registered
+                 */
+                explicit Reader (AppendLog& l) :
+                        _l (l),
+                        _s (0) {
+                    for (size_type i = 0; i != maxReaders; ++i) {
+                        bool f = false;
+                        if (_l._slots[i].used.compare_exchange_strong(f, true)) {
+                            _s = &_l._slots[i];
+                            return;}}
+                    throw std::length_error("AppendLog: too many readers");}
+
+                ~Reader () {
+                    assert(!_s->epoch.load());
+                    _s->used.store(false);}
+
+                /**
+                 returns a View of what's published now; one View per Reader at a time
+                 */
+                View view () {
+                    return View(_l, _s);}};
+
+        // ------------
+        // constructors
+        // ------------
+
+        explicit AppendLog (const allocator_type& a = allocator_type()) :
+                _a (a),
+                _ma (a),
+                _capacity (16),
+                _blocks (0),
+                _size (0),
+                _epoch (1) {
+            pointer* m = map_traits::allocate(_ma, _capacity);
+            std::fill(m, m + _capacity, pointer());
+            _map.store(m);
+            for (size_type i = 0; i != maxReaders; ++i) {
+                _slots[i].epoch.store(0);
+                _slots[i].used.store(false);}}
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         no Reader may be left
+         */
+        ~AppendLog () {
+            pointer*        m = _map.load();
+            const size_type n = _size.load();
+            for (size_type i = 0; i != n; ++i)
+                alloc_traits::destroy(_a, &m[i >> blockShift][i & (blockSize - 1)]);
+            for (size_type k = 0; k != _blocks; ++k)
+                alloc_traits::deallocate(_a, m[k], blockSize);
+            map_traits::deallocate(_ma, m, _capacity);
+            while (!_retired.empty()) {
+                map_traits::deallocate(_ma, _retired.front().map, _retired.front().capacity);
+                _retired.pop_front();}}
+
+        // ---------
+        // push_back
+        // ---------
+
+        /**
+         appends v and publishes it; the writer thread only
+         */
+        void push_back (const T& v) {
+            const size_type n = _size.load(std::memory_order_relaxed);
+            if ((n & (blockSize - 1)) == 0) {
+                if (_blocks == _capacity)
+                    grow();
+                _map.load(std::memory_order_relaxed)[_blocks++] = alloc_traits::allocate(_a, blockSize);}
+            alloc_traits::construct(_a, &_map.load(std::memory_order_relaxed)[n >> blockShift][n & (blockSize - 1)], v);
+            _size.store(n + 1, std::memory_order_release);}
+
+        /**
+         returns the i-th element; the writer thread only, readers use a View
+         */
+        const T& operator [] (size_type i) const {
+            assert(i < size());
+            return _map.load(std::memory_order_relaxed)[i >> blockShift][i & (blockSize - 1)];}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         returns the number of published elements
+         */
+        size_type size () const {
+            return _size.load(std::memory_order_acquire);}
+
+        bool empty () const {
+            return size() == 0;}
+
+        /**
+         returns the number of retired outer arrays not yet given back; the writer thread only
+         */
+        size_type retired () const {
+            return _retired.size();}};
+
+#endif // AppendLog_h
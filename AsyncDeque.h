@@ -0,0 +1,339 @@
+// ---------------------------
+// projects/deque/AsyncDeque.h
+// ---------------------------
+
+#ifndef AsyncDeque_h
+#define AsyncDeque_h
+
+#if __cplusplus < 202002L
+#error "AsyncDeque.h needs C++20 coroutines, compile with -std=c++20"
+#endif
+
+// --------
+// includes
+// --------
+
+#include <cassert>   // assert
+#include <coroutine> // coroutine_handle, suspend_never
+#include <cstddef>   // size_t
+#include <exception> // terminate
+#include <limits>    // numeric_limits
+#include <memory>    // allocator
+#include <optional>  // optional
+#include <utility>   // move
+#include <vector>    // vector
+
+#include "Deque.h"
+
+// ---------
+// AsyncLoop
+// ---------
+
+/**
+ a single-threaded run queue of coroutines that are ready to continue
+ AsyncDeque posts the waiters it wakes here instead of resuming them inside the
+ push or pop that woke them, so wakeups run in FIFO order on a flat stack
+ */
+class AsyncLoop {
+    private:
+        MyDeque< std::coroutine_handle<> > _ready;
+
+    public:
+        /**
+         queues h to be resumed by run()
+         */
+        void post (std::coroutine_handle<> h) {
+            _ready.push_back(h);}
+
+        /**
+         resumes ready coroutines, including ones they post, until none are left
+         returns the number resumed
+         */
+        std::size_t run () {
+            std::size_t n = 0;
+            while (!_ready.empty()) {
+                std::coroutine_handle<> h = _ready.front();
+                _ready.pop_front();
+                h.resume();
+                ++n;}
+            return n;}
+
+        bool empty () const {
+            return _ready.empty();}};
+
+// ---------
+// AsyncTask
+// ---------
+
+/**
+ the return type of a detached coroutine: it starts at once, runs until its
+ first suspension and frees itself when it finishes
+ */
+struct AsyncTask {
+    struct promise_type {
+        AsyncTask get_return_object () {
+            return AsyncTask();}
+
+        std::suspend_never initial_suspend () noexcept {
+            return std::suspend_never();}
+
+        std::suspend_never final_suspend () noexcept {
+            return std::suspend_never();}
+
+        void return_void ()
+            {}
+
+        void unhandled_exception () {
+            std::terminate();}};};
+
+// ----------
+// AsyncDeque
+// ----------
+
+/**
+ a FIFO of T over MyDeque for coroutines on one AsyncLoop
+ co_await pop_front() suspends while the queue is empty and co_await push_back(v)
+ suspends while a bounded queue is full; waiters are served in the order they
+ suspended and are resumed through the loop, no thread per consumer
+ not thread safe: every coroutine using it must run on the loop's thread
+ */
+template <typename T, typename A = std::allocator<T> >
+class AsyncDeque {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T                                               value_type;
+        typedef typename MyDeque<T, A>::size_type               size_type;
+
+    private:
+        // -------
+        // waiters
+        // -------
+
+        struct Consumer {
+            std::coroutine_handle<>  h;
+            std::optional<T>         slot;  // the element a producer handed over
+        };
+
+        struct Producer {
+            std::coroutine_handle<>  h;
+            const T*                 v;
+            bool                     done;  // a consumer has taken v
+        };
+
+        // ----
+        // data
+        // ----
+
+        AsyncLoop&              _loop;
+        MyDeque<T, A>           _q;
+        MyDeque<Consumer*>      _consumers;
+        MyDeque<Producer*>      _producers;
+        size_type               _capacity;
+
+        AsyncDeque (const AsyncDeque&);
+        AsyncDeque& operator = (const AsyncDeque&);
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (_q.size() <= _capacity) &&
+                   (_consumers.empty() || _q.empty()) &&
+                   (_producers.empty() || (_q.size() == _capacity));}
+
+        // ----
+        // give
+        // ----
+
+        /**
+         hands v to the first waiting consumer, or queues it
+         */
+        void give (const T& v) {
+            if (!_consumers.empty()) {
+                Consumer* c = _consumers.front();
+                _consumers.pop_front();
+                c->slot.emplace(v);
+                _loop.post(c->h);}
+            else
+                _q.push_back(v);
+            assert(valid());}
+
+        // ----
+        // take
+        // ----
+
+        /**
+         removes the front element, letting the first waiting producer into the room it leaves
+         */
+        T take () {
+            T v = std::move(_q.front());
+            _q.pop_front();
+            if (!_producers.empty()) {
+                Producer* p = _producers.front();
+                _producers.pop_front();
+                _q.push_back(*p->v);
+                p->done = true;
+                _loop.post(p->h);}
+            assert(valid());
+            return v;}
+
+    public:
+        // ----------
+        // awaitables
+        // ----------
+
+        class PopAwaiter {
+            friend class AsyncDeque;
+
+            private:
+                AsyncDeque& _d;
+                Consumer    _c;
+
+                explicit PopAwaiter (AsyncDeque& d) :
+                        _d (d)
+                    {}
+
+            public:
+                bool await_ready () const {
+                    return _d._consumers.empty() && !_d._q.empty();}
+
+                void await_suspend (std::coroutine_handle<> h) {
+                    _c.h = h;
+                    _d._consumers.push_back(&_c);}
+
+                T await_resume () {
+                    if (_c.slot)
+                        return std::move(*_c.slot);
+                    return _d.take();}};
+
+        class PopSomeAwaiter {
+            friend class AsyncDeque;
+
+            private:
+                AsyncDeque& _d;
+                Consumer    _c;
+                size_type   _max;
+
+                PopSomeAwaiter (AsyncDeque& d, size_type max) :
+                        _d (d),
+                        _max (max)
+                    {}
+
+            public:
+                bool await_ready () const {
+                    return _d._consumers.empty() && !_d._q.empty();}
+
+                void await_suspend (std::coroutine_handle<> h) {
+                    _c.h = h;
+                    _d._consumers.push_back(&_c);}
+
+                std::vector<T> await_resume () {
+                    std::vector<T> r;
+                    if (_c.slot)
+                        r.push_back(std::move(*_c.slot));
+                    while ((r.size() < _max) && !_d._q.empty())
+                        r.push_back(_d.take());
+                    return r;}};
+
+        class PushAwaiter {
+            friend class AsyncDeque;
+
+            private:
+                AsyncDeque& _d;
+                T           _v;
+                Producer    _p;
+
+                PushAwaiter (AsyncDeque& d, const T& v) :
+                        _d (d),
+                        _v (v) {
+                    _p.v    = &_v;
+                    _p.done = false;}
+
+            public:
+                bool await_ready () const {
+                    return _d._producers.empty() && (!_d._consumers.empty() || (_d._q.size() < _d._capacity));}
+
+                void await_suspend (std::coroutine_handle<> h) {
+                    _p.h = h;
+                    _d._producers.push_back(&_p);}
+
+                void await_resume () {
+                    if (!_p.done)
+                        _d.give(_v);}};
+
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         constructs an empty queue whose waiters resume on loop
+         push_back suspends once capacity elements are queued
+         */
+        explicit AsyncDeque (AsyncLoop& loop, size_type capacity = std::numeric_limits<size_type>::max()) :
+                _loop (loop),
+                _capacity (capacity) {
+            assert(capacity > 0);}
+
+        /**
+         the queue must outlive its waiters
+         */
+        ~AsyncDeque () {
+            assert(_consumers.empty() && _producers.empty());}
+
+        // ---------
+        // pop_front
+        // ---------
+
+        /**
+         co_await gives the front element, suspending until there is one
+         */
+        PopAwaiter pop_front () {
+            return PopAwaiter(*this);}
+
+        /**
+         co_await gives between 1 and max elements from the front, suspending until there is one
+         */
+        PopSomeAwaiter pop_some (size_type max) {
+            assert(max > 0);
+            return PopSomeAwaiter(*this, max);}
+
+        // ---------
+        // push_back
+        // ---------
+
+        /**
+         co_await appends v, suspending while the queue is full
+         */
+        PushAwaiter push_back (const T& v) {
+            return PushAwaiter(*this, v);}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _q.size();}
+
+        bool empty () const {
+            return _q.empty();}
+
+        size_type capacity () const {
+            return _capacity;}
+
+        /**
+         returns the number of coroutines suspended in pop_front or pop_some
+         */
+        size_type consumers () const {
+            return _consumers.size();}
+
+        /**
+         returns the number of coroutines suspended in push_back
+         */
+        size_type producers () const {
+            return _producers.size();}};
+
+#endif // AsyncDeque_h
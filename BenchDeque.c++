@@ -0,0 +1,902 @@
+// -----------------------------
+// projects/deque/BenchDeque.c++
+// -----------------------------
+
+/*
+ * BenchDeque
+ *
+ * To compile this, use the command
+ * g++ -pedantic -std=c++20 -Wall -O2 -DNDEBUG BenchDeque.c++ -o BenchDeque -lpthread
+ *
+ * Then it can run with
+ * BenchDeque [benchmark] [n]
+ *
+ * where benchmark is one of the names in main, or all
+ */
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // copy, sort
+#include <atomic>    // atomic
+#include <chrono>    // steady_clock
+#include <condition_variable> // condition_variable
+#include <cstdlib>   // atol
+#include <cstring>   // strcmp
+#include <deque>     // deque
+#include <iostream>  // cout
+#include <mutex>     // mutex, unique_lock
+#include <string>    // string
+#include <thread>    // thread
+#include <stdint.h>  // uint64_t
+#include <unordered_map> // unordered_map
+#include <vector>    // vector
+
+#include "AppendLog.h"
+#include "AsyncDeque.h"
+#include "BlockAllocator.h"
+#include "Channel.h"
+#include "CompressedDeque.h"
+#include "Deque.h"
+#include "ExpiryQueue.h"
+#include "HandleDeque.h"
+#include "RecordDeque.h"
+#include "ShardedQueue.h"
+#include "SoADeque.h"
+#include "Window.h"
+
+// -------
+// seconds
+// -------
+
+typedef std::chrono::steady_clock bench_clock;
+
+double seconds (bench_clock::time_point b, bench_clock::time_point e) {
+    return std::chrono::duration<double>(e - b).count();}
+
+// ------
+// Record
+// ------
+
+struct Record {
+    uint64_t timestamp;
+    uint64_t payload;};
+
+bool operator < (const Record& lhs, const Record& rhs) {
+    return lhs.timestamp < rhs.timestamp;}
+
+// --------------
+// fill_shuffled
+// --------------
+
+template <typename I>
+void fill_shuffled (I b, I e) {
+    uint64_t x = 88172645463325252ULL;
+    uint64_t i = 0;
+    while (b != e) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        b->timestamp = x % 1000000007ULL;
+        b->payload   = i++;
+        ++b;}}
+
+// ----------
+// bench_sort
+// ----------
+
+void bench_sort (size_t n) {
+    std::cout << "sort " << n << " records of " << sizeof(Record) << " bytes" << std::endl;
+    {
+    MyDeque<Record> d(n);
+    fill_shuffled(d.begin(), d.end());
+    bench_clock::time_point b = bench_clock::now();
+    std::vector<Record> v(d.begin(), d.end());
+    std::sort(v.begin(), v.end());
+    std::copy(v.begin(), v.end(), d.begin());
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  vector + std::sort     " << seconds(b, e) << " s, scratch " << n * sizeof(Record) << " bytes" << std::endl;
+    }
+    {
+    MyDeque<Record> d(n);
+    fill_shuffled(d.begin(), d.end());
+    bench_clock::time_point b = bench_clock::now();
+    d.sort();
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque::sort          " << seconds(b, e) << " s, scratch " << n / 16 * sizeof(Record) << " bytes" << std::endl;
+    }
+    {
+    MyDeque<Record> d(n);
+    fill_shuffled(d.begin(), d.end());
+    bench_clock::time_point b = bench_clock::now();
+    d.stable_sort();
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque::stable_sort   " << seconds(b, e) << " s, scratch " << n / 16 * sizeof(Record) << " bytes" << std::endl;
+    }}
+
+// -------------
+// bench_iterate
+// -------------
+
+template <typename I>
+long sum (I b, I e) {
+    long s = 0;
+    while (b != e) {
+        s += *b;
+        ++b;}
+    return s;}
+
+void bench_iterate (size_t n) {
+    std::cout << "iterate " << n << " ints, 10 passes" << std::endl;
+    std::vector<int> v(n, 1);
+    MyDeque<int>     d(n, 1);
+    std::deque<int>  q(n, 1);
+    long s = 0;
+
+    bench_clock::time_point b = bench_clock::now();
+    for (int i = 0; i != 10; ++i)
+        s += sum(&v[0], &v[0] + n);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  raw pointer            " << seconds(b, e) << " s" << std::endl;
+
+    b = bench_clock::now();
+    for (int i = 0; i != 10; ++i)
+        s += sum(d.begin(), d.end());
+    e = bench_clock::now();
+    std::cout << "  MyDeque::iterator      " << seconds(b, e) << " s" << std::endl;
+
+    b = bench_clock::now();
+    for (int i = 0; i != 10; ++i)
+        s += sum(q.begin(), q.end());
+    e = bench_clock::now();
+    std::cout << "  std::deque::iterator   " << seconds(b, e) << " s" << std::endl;
+
+    if (s != 30 * static_cast<long>(n))
+        std::cout << "  sum mismatch" << std::endl;}
+
+// ------------
+// bench_random
+// ------------
+
+template <typename C>
+long probe (C& c, size_t n, size_t k) {
+    uint64_t x = 88172645463325252ULL;
+    long     s = 0;
+    for (size_t i = 0; i != k; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        s += c[x % n];}
+    return s;}
+
+void bench_random (size_t n) {
+    const size_t k = 10000000;
+    std::cout << "random " << k << " reads of " << n << " ints" << std::endl;
+    long s = 0;
+    {
+    MyDeque<int> d(n, 1);
+    bench_clock::time_point b = bench_clock::now();
+    s += probe(d, n, k);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque                " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    MyDeque<int, BlockAllocator<int> > d(n, 1);
+    bench_clock::time_point b = bench_clock::now();
+    s += probe(d, n, k);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque BlockAllocator " << seconds(b, e) << " s, "
+              << d.get_allocator().arena().regions() << " huge page regions" << std::endl;
+    }
+    {
+    std::deque<int> q(n, 1);
+    bench_clock::time_point b = bench_clock::now();
+    s += probe(q, n, k);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  std::deque             " << seconds(b, e) << " s" << std::endl;
+    }
+    if (s != 3 * static_cast<long>(k))
+        std::cout << "  sum mismatch" << std::endl;}
+
+// -------------
+// bench_records
+// -------------
+
+void bench_records (size_t n) {
+    std::cout << "records " << n << " messages of 20 to 4096 bytes, push all then pop all" << std::endl;
+    const std::string m(4096, 'm');
+    size_t bytes = 0;
+    {
+    MyDeque<std::string> d;
+    bench_clock::time_point b = bench_clock::now();
+    for (size_t i = 0; i != n; ++i)
+        d.push_back(std::string(m.data(), 20 + (i * 2654435761u) % 4077));
+    while (!d.empty()) {
+        bytes += d.front().size();
+        d.pop_front();}
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque<std::string>   " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    RecordDeque<> d;
+    bench_clock::time_point b = bench_clock::now();
+    for (size_t i = 0; i != n; ++i)
+        d.push_back(m.data(), 20 + (i * 2654435761u) % 4077);
+    const size_t blocks = d.blocks();
+    while (!d.empty()) {
+        bytes -= d.front().size();
+        d.pop_front();}
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  RecordDeque            " << seconds(b, e) << " s, " << blocks << " blocks" << std::endl;
+    }
+    if (bytes != 0)
+        std::cout << "  size mismatch" << std::endl;}
+
+// -------------
+// bench_columns
+// -------------
+
+struct Tick {
+    uint64_t timestamp;
+    double   price;
+    uint32_t qty;
+    uint32_t flags;};
+
+void bench_columns (size_t n) {
+    std::cout << "columns " << n << " ticks, sum of price, 10 passes" << std::endl;
+    double s = 0;
+    {
+    MyDeque<Tick> d;
+    for (size_t i = 0; i != n; ++i) {
+        Tick t = {i, 1.0, 1, 0};
+        d.push_back(t);}
+    bench_clock::time_point b = bench_clock::now();
+    for (int j = 0; j != 10; ++j)
+        for (MyDeque<Tick>::iterator i = d.begin(); i != d.end(); ++i)
+            s += i->price;
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque<Tick>          " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    SoADeque<uint64_t, double, uint32_t, uint32_t> d;
+    for (size_t i = 0; i != n; ++i)
+        d.push_back(i, 1.0, 1, 0);
+    bench_clock::time_point b = bench_clock::now();
+    for (int j = 0; j != 10; ++j)
+        for (size_t k = 0; k != d.segments(); ++k) {
+            std::pair<double*, double*> r = d.segment<1>(k);
+            for (double* p = r.first; p != r.second; ++p)
+                s += *p;}
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  SoADeque column        " << seconds(b, e) << " s" << std::endl;
+    }
+    if (s != 20.0 * n)
+        std::cout << "  sum mismatch" << std::endl;}
+
+// ------------
+// bench_wakeup
+// ------------
+
+AsyncTask ping (AsyncDeque<int>& out, AsyncDeque<int>& in, size_t n) {
+    for (size_t i = 0; i != n; ++i) {
+        co_await out.push_back(1);
+        co_await in.pop_front();}}
+
+AsyncTask pong (AsyncDeque<int>& in, AsyncDeque<int>& out, size_t n) {
+    for (size_t i = 0; i != n; ++i)
+        co_await out.push_back(co_await in.pop_front());}
+
+struct LockedDeque {
+    std::mutex              m;
+    std::condition_variable c;
+    MyDeque<int>            q;
+
+    void push_back (int v) {
+        {
+        std::lock_guard<std::mutex> l(m);
+        q.push_back(v);
+        }
+        c.notify_one();}
+
+    int pop_front () {
+        std::unique_lock<std::mutex> l(m);
+        while (q.empty())
+            c.wait(l);
+        int v = q.front();
+        q.pop_front();
+        return v;}};
+
+void bench_wakeup (size_t n) {
+    std::cout << "wakeup " << n << " round trips between two consumers" << std::endl;
+    {
+    AsyncLoop       l;
+    AsyncDeque<int> a(l);
+    AsyncDeque<int> b(l);
+    bench_clock::time_point s = bench_clock::now();
+    pong(a, b, n);
+    ping(a, b, n);
+    l.run();
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  AsyncDeque coroutines  " << seconds(s, e) / n * 1e9 / 2 << " ns per wakeup" << std::endl;
+    }
+    {
+    LockedDeque a;
+    LockedDeque b;
+    bench_clock::time_point s = bench_clock::now();
+    std::thread t([&] () {
+        for (size_t i = 0; i != n; ++i)
+            b.push_back(a.pop_front());});
+    for (size_t i = 0; i != n; ++i) {
+        a.push_back(1);
+        b.pop_front();}
+    t.join();
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  condition_variable     " << seconds(s, e) / n * 1e9 / 2 << " ns per wakeup" << std::endl;
+    }}
+
+// -------------
+// bench_channel
+// -------------
+
+void bench_channel (size_t n) {
+    std::cout << "channel " << n << " timestamps through a 1024 slot Channel, batches of 16 in and 64 out" << std::endl;
+    for (int k = 1; k <= 32; k *= 2) {
+        Channel<int64_t> c(1024);
+        std::vector<std::vector<uint32_t> > ns(k);
+        std::vector<std::thread> t;
+        bench_clock::time_point b = bench_clock::now();
+        for (int p = 0; p != k; ++p)
+            t.push_back(std::thread([&c, n, k] () {
+                int64_t batch[16];
+                for (size_t i = 0; i < n / k; i += 16) {
+                    const int64_t now = bench_clock::now().time_since_epoch().count();
+                    for (int j = 0; j != 16; ++j)
+                        batch[j] = now;
+                    c.push_n(batch, batch + 16);}}));
+        for (int q = 0; q != k; ++q)
+            t.push_back(std::thread([&c, &ns, q] () {
+                int64_t batch[64];
+                size_t got;
+                while ((got = c.pop_n(batch, 64)) != 0) {
+                    const int64_t now = bench_clock::now().time_since_epoch().count();
+                    for (size_t j = 0; j != got; ++j)
+                        ns[q].push_back(static_cast<uint32_t>(now - batch[j]));}}));
+        for (int p = 0; p != k; ++p)
+            t[p].join();
+        c.close();
+        for (int q = 0; q != k; ++q)
+            t[k + q].join();
+        bench_clock::time_point e = bench_clock::now();
+        std::vector<uint32_t> all;
+        for (int q = 0; q != k; ++q)
+            all.insert(all.end(), ns[q].begin(), ns[q].end());
+        if (all.empty())
+            continue;
+        std::sort(all.begin(), all.end());
+        std::cout << "  " << k << " x " << k << "\t" << all.size() / seconds(b, e) / 1e6 << " M/s, p99 handoff "
+                  << all[all.size() * 99 / 100] / 1000 << " us" << std::endl;}}
+
+// ------------
+// bench_window
+// ------------
+
+void bench_window (size_t n) {
+    std::cout << "window rolling min and sum over " << n << " ticks, ns per tick" << std::endl;
+    std::vector<double> v(n);
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i != n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        v[i] = double(x % 1000000);}
+    for (size_t w = 100; w <= 1000000; w *= 10) {
+        double s = 0;
+        bench_clock::time_point b = bench_clock::now();
+        MinWindow<double>       lo;
+        AggregateWindow<double> sum;
+        for (size_t i = 0; i != n; ++i) {
+            lo.push(v[i]);
+            lo.keep_last(w);
+            sum.push(v[i]);
+            sum.keep_last(w);
+            s += lo.top() + sum.value();}
+        bench_clock::time_point e = bench_clock::now();
+        const double fast = seconds(b, e) / n * 1e9;
+
+        // the rescan is O(w) a tick, so it gets fewer ticks, starting with a full window
+        const size_t f0 = (n > w) ? w - 1 : 0;
+        const size_t m  = std::min(n - f0, std::max(size_t(1000), size_t(200000000) / w));
+        b = bench_clock::now();
+        for (size_t i = f0; i != f0 + m; ++i) {
+            const size_t f = (i + 1 > w) ? i + 1 - w : 0;
+            s += *std::min_element(&v[f], &v[i] + 1);
+            double t = 0;
+            for (size_t j = f; j <= i; ++j)
+                t += v[j];
+            s += t;}
+        e = bench_clock::now();
+        std::cout << "  window " << w << "\tMinWindow + AggregateWindow " << fast
+                  << "\trescan " << seconds(b, e) / m * 1e9 << std::endl;
+        if (s == 42)
+            std::cout << "";}}
+
+// ------------
+// bench_splice
+// ------------
+
+void bench_splice (size_t n) {
+    std::cout << "splice " << n << " ints, 16 chunks" << std::endl;
+    const size_t k = 16;
+    {
+    MyDeque<int> d(n, 1);
+    bench_clock::time_point b = bench_clock::now();
+    std::vector< MyDeque<int> > c(k);
+    for (size_t i = 0; i != k; ++i)
+        for (size_t j = i * (n / k); j != ((i + 1 == k) ? n : (i + 1) * (n / k)); ++j)
+            c[i].push_back(d[j]);
+    d.clear();
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  copy into chunks       " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    MyDeque<int> d(n, 1);
+    bench_clock::time_point b = bench_clock::now();
+    std::vector< MyDeque<int> > c(k);
+    for (size_t i = k; i-- != 0; )
+        c[i] = d.split_at(i * (n / k));
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  split_at into chunks   " << seconds(b, e) << " s" << std::endl;
+    b = bench_clock::now();
+    for (size_t i = 0; i != k; ++i)
+        d.splice_back(std::move(c[i]));
+    e = bench_clock::now();
+    std::cout << "  splice_back them again " << seconds(b, e) << " s" << std::endl;
+    if (d.size() != n)
+        std::cout << "  size mismatch" << std::endl;
+    }
+    {
+    std::vector< MyDeque<int> > c(k, MyDeque<int>(n / k, 1));
+    MyDeque<int> d;
+    bench_clock::time_point b = bench_clock::now();
+    for (size_t i = 0; i != k; ++i)
+        for (MyDeque<int>::iterator j = c[i].begin(); j != c[i].end(); ++j)
+            d.push_back(*j);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  merge shards by copy   " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    std::vector< MyDeque<int> > c(k, MyDeque<int>(n / k, 1));
+    MyDeque<int> d;
+    bench_clock::time_point b = bench_clock::now();
+    for (size_t i = 0; i != k; ++i)
+        d.splice_back(std::move(c[i]));
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  merge shards by splice " << seconds(b, e) << " s (whole inner arrays only if n / 16 is a multiple of "
+              << MyDeque<int>::sizeArray << ", else each shard's elements moved, O(shard))" << std::endl;
+    }}
+
+// -------------
+// bench_handles
+// -------------
+
+// a job queue: push n jobs keeping a reference to each, look up and cancel 1 in 10
+// at random, then pop the rest, against std::deque of ids and an unordered_map of jobs
+void bench_handles (size_t n) {
+    std::cout << "handles " << n << " jobs, 10% cancelled" << std::endl;
+    std::vector<size_t> pick(n / 10);
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i != pick.size(); ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        pick[i] = x % n;}
+    long s = 0;
+    {
+    bench_clock::time_point b = bench_clock::now();
+    std::deque<uint64_t>              q;
+    std::unordered_map<uint64_t, int> jobs;
+    for (size_t i = 0; i != n; ++i) {
+        q.push_back(i);
+        jobs[i] = int(i);}
+    for (size_t i = 0; i != pick.size(); ++i) {
+        std::unordered_map<uint64_t, int>::iterator p = jobs.find(pick[i]);
+        if (p != jobs.end()) {
+            s += p->second;
+            jobs.erase(p);}}
+    while (!q.empty()) {
+        std::unordered_map<uint64_t, int>::iterator p = jobs.find(q.front());
+        q.pop_front();
+        if (p != jobs.end()) {
+            s += p->second;
+            jobs.erase(p);}}
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  std::deque + unordered_map " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    bench_clock::time_point b = bench_clock::now();
+    HandleDeque<int>         q;
+    std::vector<DequeHandle> h(n);
+    for (size_t i = 0; i != n; ++i)
+        h[i] = q.push_back(int(i));
+    for (size_t i = 0; i != pick.size(); ++i)
+        if (const int* p = q.get(h[pick[i]])) {
+            s += *p;
+            q.cancel(h[pick[i]]);}
+    while (!q.empty()) {
+        s += q.front();
+        q.pop_front();}
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  HandleDeque                " << seconds(b, e) << " s" << std::endl;
+    }
+    if (s == 42)
+        std::cout << s << std::endl;}
+
+// ------------
+// bench_expiry
+// ------------
+
+// a TTL queue of n entries, expired in sweeps of about k at a time, by popping
+// while front() is old enough and by ExpiryQueue's binary search and bulk pop
+void bench_expiry (size_t n) {
+    std::cout << "expiry " << n << " entries, ns per entry" << std::endl;
+    typedef std::pair<uint64_t, uint64_t> entry;
+    for (size_t k = 1; k <= 100000; k *= 100) {
+        uint64_t s = 0;
+        {
+        MyDeque<entry> d;
+        for (size_t i = 0; i != n; ++i)
+            d.push_back(entry(i, i));
+        bench_clock::time_point b = bench_clock::now();
+        for (uint64_t t = k - 1; !d.empty(); t += k)
+            while (!d.empty() && (d.front().first <= t)) {
+                s += d.front().second;
+                d.pop_front();}
+        bench_clock::time_point e = bench_clock::now();
+        std::cout << "  sweeps of " << k << ", pop_front loop  " << seconds(b, e) / n * 1e9 << std::endl;
+        }
+        {
+        ExpiryQueue<entry> d;
+        for (size_t i = 0; i != n; ++i)
+            d.push(entry(i, i));
+        bench_clock::time_point b = bench_clock::now();
+        for (uint64_t t = k - 1; !d.empty(); t += k)
+            d.expire_until(t, [&s] (const entry* p, const entry* q) {
+                for (; p != q; ++p)
+                    s += p->second;});
+        bench_clock::time_point e = bench_clock::now();
+        std::cout << "  sweeps of " << k << ", expire_until    " << seconds(b, e) / n * 1e9 << std::endl;
+        }
+        if (s == 42)
+            std::cout << s << std::endl;}}
+
+// ----------------
+// bench_compressed
+// ----------------
+
+// n increasing 64-bit timestamps a few units apart: memory, push, random reads and pops
+void bench_compressed (size_t n) {
+    std::cout << "compressed " << n << " increasing uint64_t" << std::endl;
+    std::vector<uint64_t> v(n);
+    uint64_t x = 88172645463325252ULL;
+    uint64_t t = 1700000000000000ULL;
+    for (size_t i = 0; i != n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        v[i] = t += x % 1000;}
+    const size_t k = std::min(n, size_t(1000000));
+    uint64_t s = 0;
+    {
+    bench_clock::time_point b = bench_clock::now();
+    MyDeque<uint64_t> d;
+    for (size_t i = 0; i != n; ++i)
+        d.push_back(v[i]);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque         bytes " << n * sizeof(uint64_t) << ", push " << seconds(b, e) << " s";
+    b = bench_clock::now();
+    for (size_t i = 0; i != k; ++i)
+        s += d[(v[i] * 2654435761ULL) % n];
+    e = bench_clock::now();
+    std::cout << ", " << k << " reads " << seconds(b, e) << " s";
+    b = bench_clock::now();
+    while (!d.empty()) {
+        s += d.front();
+        d.pop_front();}
+    e = bench_clock::now();
+    std::cout << ", pop " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    bench_clock::time_point b = bench_clock::now();
+    CompressedDeque<uint64_t> d;
+    for (size_t i = 0; i != n; ++i)
+        d.push_back(v[i]);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  CompressedDeque bytes " << d.bytes() << ", push " << seconds(b, e) << " s";
+    b = bench_clock::now();
+    for (size_t i = 0; i != k; ++i)
+        s += d[(v[i] * 2654435761ULL) % n];
+    e = bench_clock::now();
+    std::cout << ", " << k << " reads " << seconds(b, e) << " s";
+    b = bench_clock::now();
+    while (!d.empty()) {
+        s += d.front();
+        d.pop_front();}
+    e = bench_clock::now();
+    std::cout << ", pop " << seconds(b, e) << " s" << std::endl;
+    }
+    if (s == 42)
+        std::cout << s << std::endl;}
+
+// -----------
+// bench_flags
+// -----------
+
+// n flags: push_back, count and find the last set one, a byte per flag
+// (MyDeque<char>, std::deque<bool>) against MyDeque<bool>'s bit per flag
+void bench_flags (size_t n) {
+    std::cout << "flags " << n << " bools, 1 in 1000 set" << std::endl;
+    size_t s = 0;
+    {
+    MyDeque<char> d;
+    bench_clock::time_point b = bench_clock::now();
+    for (size_t i = 0; i != n; ++i)
+        d.push_back((i % 1000) == 999);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque<char>    bytes " << n << ", push " << seconds(b, e) << " s";
+    b = bench_clock::now();
+    s += std::count(d.begin(), d.end(), char(1));
+    d[n - 1] = 0;
+    d[n / 2] = 1;
+    s += std::find(d.begin() + (n / 2 + 1), d.end(), char(1)) - d.begin();
+    e = bench_clock::now();
+    std::cout << ", count and find " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    std::deque<bool> d;
+    bench_clock::time_point b = bench_clock::now();
+    for (size_t i = 0; i != n; ++i)
+        d.push_back((i % 1000) == 999);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  std::deque<bool> bytes " << n << ", push " << seconds(b, e) << " s";
+    b = bench_clock::now();
+    s += std::count(d.begin(), d.end(), true);
+    d[n - 1] = 0;
+    d[n / 2] = 1;
+    s += std::find(d.begin() + (n / 2 + 1), d.end(), true) - d.begin();
+    e = bench_clock::now();
+    std::cout << ", count and find " << seconds(b, e) << " s" << std::endl;
+    }
+    {
+    MyDeque<bool> d;
+    bench_clock::time_point b = bench_clock::now();
+    for (size_t i = 0; i != n; ++i)
+        d.push_back((i % 1000) == 999);
+    bench_clock::time_point e = bench_clock::now();
+    std::cout << "  MyDeque<bool>    bytes " << d.bytes() << ", push " << seconds(b, e) << " s";
+    b = bench_clock::now();
+    s += d.count();
+    d[n - 1] = false;
+    d[n / 2] = true;
+    s += d.find_first();
+    e = bench_clock::now();
+    std::cout << ", count and find " << seconds(b, e) << " s" << std::endl;
+    }
+    if (s == 42)
+        std::cout << s << std::endl;}
+
+// ---------
+// bench_log
+// ---------
+
+// one writer appending n ints while k readers each make n / 16 reads at random
+// below the published size, for k up to 32: a mutex around a MyDeque, taken by
+// the writer per push and the readers per read, against AppendLog, with a View
+// taken per 64 reads
+void bench_log (size_t n) {
+    std::cout << "log 1 writer, " << n << " appends, k readers, " << n / 16 << " reads each, M reads/s" << std::endl;
+    const size_t m = n / 16;
+    for (int k = 1; k <= 32; k *= 2) {
+        size_t s = 0;
+        {
+        std::mutex        mu;
+        MyDeque<size_t>   d;
+        std::atomic<int>  done(0);
+        std::vector<size_t> sums(k);
+        std::vector<std::thread> t;
+        d.push_back(0);
+        bench_clock::time_point b = bench_clock::now();
+        for (int r = 0; r != k; ++r)
+            t.push_back(std::thread([&mu, &d, &done, &sums, m, r] () {
+                uint64_t x = 88172645463325252ULL + r;
+                for (size_t i = 0; i != m; ++i) {
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+                    std::lock_guard<std::mutex> l(mu);
+                    sums[r] += d[x % d.size()];}
+                ++done;}));
+        for (size_t i = 1; (i != n) && (done != k); ++i) {
+            std::lock_guard<std::mutex> l(mu);
+            d.push_back(i);}
+        for (int r = 0; r != k; ++r)
+            t[r].join();
+        bench_clock::time_point e = bench_clock::now();
+        for (int r = 0; r != k; ++r)
+            s += sums[r];
+        std::cout << "  " << k << " readers\tmutex     " << k * m / seconds(b, e) / 1e6;
+        }
+        {
+        AppendLog<size_t> d;
+        std::atomic<int>  done(0);
+        std::vector<size_t> sums(k);
+        std::vector<std::thread> t;
+        d.push_back(0);
+        bench_clock::time_point b = bench_clock::now();
+        for (int r = 0; r != k; ++r)
+            t.push_back(std::thread([&d, &done, &sums, m, r] () {
+                AppendLog<size_t>::Reader rd(d);
+                uint64_t x = 88172645463325252ULL + r;
+                for (size_t i = 0; i < m; i += 64) {
+                    AppendLog<size_t>::View v = rd.view();
+                    for (size_t j = 0; j != 64; ++j) {
+                        x ^= x << 13;
+                        x ^= x >> 7;
+                        x ^= x << 17;
+                        sums[r] += v[x % v.size()];}}
+                ++done;}));
+        for (size_t i = 1; (i != n) && (done != k); ++i)
+            d.push_back(i);
+        for (int r = 0; r != k; ++r)
+            t[r].join();
+        bench_clock::time_point e = bench_clock::now();
+        for (int r = 0; r != k; ++r)
+            s += sums[r];
+        std::cout << "\tAppendLog " << k * m / seconds(b, e) / 1e6 << std::endl;
+        }
+        if (s == 42)
+            std::cout << s << std::endl;}}
+
+// -------------
+// bench_sharded
+// -------------
+
+// k threads, each pushing n / k ints and popping as many, in turns of 64: one
+// MyDeque behind one mutex, taken per operation, against a ShardedQueue of k
+// shards, for k up to 64
+void bench_sharded (size_t n) {
+    std::cout << "sharded k threads, " << n << " pushes and pops in all, M ops/s" << std::endl;
+    for (int k = 1; k <= 64; k *= 2) {
+        const size_t m = n / k;
+        long s = 0;
+        {
+        std::mutex       mu;
+        MyDeque<long>    d;
+        std::vector<long> sums(k);
+        std::vector<std::thread> t;
+        bench_clock::time_point b = bench_clock::now();
+        for (int r = 0; r != k; ++r)
+            t.push_back(std::thread([&mu, &d, &sums, m, r] () {
+                for (size_t i = 0; i < m; i += 64) {
+                    for (size_t j = 0; j != 64; ++j) {
+                        std::lock_guard<std::mutex> l(mu);
+                        d.push_back(long(i + j));}
+                    for (size_t j = 0; j != 64; ++j) {
+                        std::lock_guard<std::mutex> l(mu);
+                        if (!d.empty()) {
+                            sums[r] += d.front();
+                            d.pop_front();}}}}));
+        for (int r = 0; r != k; ++r)
+            t[r].join();
+        bench_clock::time_point e = bench_clock::now();
+        for (int r = 0; r != k; ++r)
+            s += sums[r];
+        std::cout << "  " << k << " threads\tmutex   " << 2 * k * m / seconds(b, e) / 1e6;
+        }
+        {
+        ShardedQueue<long> d(k);
+        std::vector<long>  sums(k);
+        std::vector<std::thread> t;
+        bench_clock::time_point b = bench_clock::now();
+        for (int r = 0; r != k; ++r)
+            t.push_back(std::thread([&d, &sums, m, r] () {
+                ShardedQueue<long>::Local l(d);
+                long v;
+                for (size_t i = 0; i < m; i += 64) {
+                    for (size_t j = 0; j != 64; ++j)
+                        l.push(long(i + j));
+                    for (size_t j = 0; j != 64; ++j)
+                        if (l.pop(v))
+                            sums[r] += v;}}));
+        for (int r = 0; r != k; ++r)
+            t[r].join();
+        bench_clock::time_point e = bench_clock::now();
+        for (int r = 0; r != k; ++r)
+            s += sums[r];
+        std::cout << "\tsharded " << 2 * k * m / seconds(b, e) / 1e6 << std::endl;
+        }
+        if (s == 42)
+            std::cout << s << std::endl;}}
+
+// -------------
+// bench_latency
+// -------------
+
+// prints the worst time, the 99.999th percentile and how many took over 100 us
+void print_latency (std::vector<uint32_t>& ns) {
+    std::sort(ns.begin(), ns.end());
+    const size_t n = ns.size();
+    std::cout << "max " << ns[n - 1] << "\tp99.999 " << ns[n - 1 - n / 100000]
+              << "\tover 100us " << (ns.end() - std::upper_bound(ns.begin(), ns.end(), 100000));}
+
+// time of one push_back over n of them, then of one push_back or pop_front
+// in a FIFO holding n, with incremental growth off and on
+void bench_latency (size_t n) {
+    std::cout << "latency of one operation over " << n << ", ns" << std::endl;
+    std::vector<uint32_t> ns(n);
+    for (int on = 0; on != 2; ++on) {
+        MyDeque<int> d;
+        d.incremental_growth(on != 0);
+        for (size_t i = 0; i != n; ++i) {
+            bench_clock::time_point b = bench_clock::now();
+            d.push_back(int(i));
+            bench_clock::time_point e = bench_clock::now();
+            ns[i] = uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(e - b).count());}
+        std::cout << "  incremental " << (on ? "on " : "off") << " push_back\t";
+        print_latency(ns);
+        std::cout << std::endl;
+        for (size_t i = 0; i != n; ++i) {
+            bench_clock::time_point b = bench_clock::now();
+            if (i % 2)
+                d.pop_front();
+            else
+                d.push_back(int(i));
+            bench_clock::time_point e = bench_clock::now();
+            ns[i] = uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(e - b).count());}
+        std::cout << "  incremental " << (on ? "on " : "off") << " FIFO\t\t";
+        print_latency(ns);
+        std::cout << std::endl;}}
+
+// ----
+// main
+// ----
+
+int main (int argc, char* argv[]) {
+    const char* which = (argc > 1) ? argv[1] : "all";
+    const size_t n     = (argc > 2) ? std::atol(argv[2]) : 10000000;
+    const bool   all   = std::strcmp(which, "all") == 0;
+
+    if (all || (std::strcmp(which, "sort") == 0))
+        bench_sort(n);
+    if (all || (std::strcmp(which, "iterate") == 0))
+        bench_iterate(n);
+    if (all || (std::strcmp(which, "random") == 0))
+        bench_random(n);
+    if (all || (std::strcmp(which, "records") == 0))
+        bench_records(n / 10);
+    if (all || (std::strcmp(which, "columns") == 0))
+        bench_columns(n);
+    if (all || (std::strcmp(which, "wakeup") == 0))
+        bench_wakeup(n / 100);
+    if (all || (std::strcmp(which, "channel") == 0))
+        bench_channel(n);
+    if (all || (std::strcmp(which, "window") == 0))
+        bench_window(n);
+    if (all || (std::strcmp(which, "splice") == 0))
+        bench_splice(n);
+    if (all || (std::strcmp(which, "handles") == 0))
+        bench_handles(n);
+    if (all || (std::strcmp(which, "expiry") == 0))
+        bench_expiry(n);
+    if (all || (std::strcmp(which, "compressed") == 0))
+        bench_compressed(n);
+    if (all || (std::strcmp(which, "flags") == 0))
+        bench_flags(n);
+    if (all || (std::strcmp(which, "log") == 0))
+        bench_log(n);
+    if (all || (std::strcmp(which, "sharded") == 0))
+        bench_sharded(n);
+    if (all || (std::strcmp(which, "latency") == 0))
+        bench_latency(n);
+
+    return 0;}
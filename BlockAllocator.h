@@ -0,0 +1,210 @@
+// -------------------------------
+// projects/deque/BlockAllocator.h
+// -------------------------------
+
+#ifndef BlockAllocator_h
+#define BlockAllocator_h
+
+// --------
+// includes
+// --------
+
+#include <cstddef>   // size_t
+#include <cstdlib>   // free, posix_memalign
+#include <iterator>  // prev
+#include <map>       // map
+#include <memory>    // shared_ptr
+#include <mutex>     // mutex, lock_guard
+#include <new>       // bad_alloc
+#include <set>       // set
+#include <vector>    // vector
+
+#ifdef __linux__
+#include <sys/mman.h> // madvise, MADV_HUGEPAGE
+#endif
+
+// ----------
+// BlockArena
+// ----------
+
+/**
+ the memory behind one family of BlockAllocators
+ everything it hands out is aligned to at least 64 bytes; once the bytes it has
+ out reach the threshold, allocations of up to 256 KB are carved out of 2 MB
+ regions that the kernel is asked to back with huge pages, and freed pieces are
+ kept for reuse by allocations of the same size until the arena goes away
+ */
+class BlockArena {
+    public:
+        static const std::size_t regionSize = std::size_t(2) << 20;
+
+    private:
+        std::mutex                                      _m;
+        std::size_t                                     _live;   // bytes handed out and not yet returned
+        std::set<char*>                                 _regions;
+        char*                                           _next;   // bump pointer in the newest region
+        char*                                           _end;
+        std::map<std::size_t, std::vector<char*> >      _free;   // carved pieces by size
+
+        BlockArena (const BlockArena&);
+        BlockArena& operator = (const BlockArena&);
+
+        static void* aligned (std::size_t bytes, std::size_t align) {
+            void* p = 0;
+            if (posix_memalign(&p, align, bytes ? bytes : align))
+                throw std::bad_alloc();
+            return p;}
+
+        bool carved (char* p) const {
+            std::set<char*>::const_iterator i = _regions.upper_bound(p);
+            return (i != _regions.begin()) && (p < *std::prev(i) + regionSize);}
+
+        char* carve (std::size_t bytes) {
+            std::vector<char*>& f = _free[bytes];
+            if (!f.empty()) {
+                char* p = f.back();
+                f.pop_back();
+                return p;}
+            if (_next + bytes > _end) {
+                _next = static_cast<char*>(aligned(regionSize, regionSize));
+                _end  = _next + regionSize;
+                #ifdef MADV_HUGEPAGE
+                madvise(_next, regionSize, MADV_HUGEPAGE);
+                #endif
+                _regions.insert(_next);}
+            char* p = _next;
+            _next += bytes;
+            return p;}
+
+    public:
+        BlockArena () :
+                _live (0),
+                _next (0),
+                _end (0)
+            {}
+
+        ~BlockArena () {
+            for (std::set<char*>::iterator i = _regions.begin(); i != _regions.end(); ++i)
+                std::free(*i);}
+
+        /**
+         returns bytes aligned to align, carved out of a huge page region once
+         threshold bytes are live
+         */
+        void* allocate (std::size_t bytes, std::size_t align, std::size_t threshold) {
+            std::lock_guard<std::mutex> l(_m);
+            const std::size_t rounded = (bytes + align - 1) / align * align;
+            void* p;
+            if ((_live >= threshold) && (rounded <= regionSize / 8) && (align <= regionSize))
+                p = carve(rounded);
+            else
+                p = aligned(rounded, align);
+            _live += rounded;
+            return p;}
+
+        void deallocate (void* p, std::size_t bytes, std::size_t align) {
+            std::lock_guard<std::mutex> l(_m);
+            const std::size_t rounded = (bytes + align - 1) / align * align;
+            _live -= rounded;
+            if (carved(static_cast<char*>(p)))
+                _free[rounded].push_back(static_cast<char*>(p));
+            else
+                std::free(p);}
+
+        /**
+         returns whether p was carved out of one of this arena's regions
+         */
+        bool owns (const void* p) {
+            std::lock_guard<std::mutex> l(_m);
+            return carved(static_cast<char*>(const_cast<void*>(p)));}
+
+        /**
+         returns the arena that default-constructed BlockAllocators share
+         */
+        static std::shared_ptr<BlockArena> shared () {
+            static const std::shared_ptr<BlockArena> a = std::make_shared<BlockArena>();
+            return a;}
+
+        /**
+         returns the number of 2 MB regions carved so far
+         */
+        std::size_t regions () {
+            std::lock_guard<std::mutex> l(_m);
+            return _regions.size();}};
+
+// --------------
+// BlockAllocator
+// --------------
+
+/**
+ allocator policy for MyDeque's inner arrays
+ aligns every allocation to Align bytes (64, a cache line, or the SIMD width)
+ and, once Threshold bytes are live, carves them out of huge page regions so
+ random access over a very large deque touches fewer TLB entries
+ copies and rebinds share one BlockArena and compare equal; so do all default
+ constructed ones, which share BlockArena::shared(), so deques made apart can
+ still swap, move-assign and splice without copying elements (the price: that
+ arena keeps its regions for the life of the program); pass an arena of your
+ own to keep a deque's memory apart
+ */
+template <typename T, std::size_t Align = 64, std::size_t Threshold = (std::size_t(32) << 20)>
+class BlockAllocator {
+    template <typename U, std::size_t, std::size_t>
+    friend class BlockAllocator;
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind {
+            typedef BlockAllocator<U, Align, Threshold> other;};
+
+    private:
+        std::shared_ptr<BlockArena> _arena;
+
+        static std::size_t alignment () {
+            return (Align < alignof(T)) ? alignof(T) : Align;}
+
+    public:
+        BlockAllocator () :
+                _arena (BlockArena::shared())
+            {}
+
+        explicit BlockAllocator (const std::shared_ptr<BlockArena>& arena) :
+                _arena (arena)
+            {}
+
+        template <typename U>
+        BlockAllocator (const BlockAllocator<U, Align, Threshold>& that) :
+                _arena (that._arena)
+            {}
+
+        pointer allocate (size_type n) {
+            return static_cast<pointer>(_arena->allocate(n * sizeof(T), alignment(), Threshold));}
+
+        void deallocate (pointer p, size_type n) {
+            _arena->deallocate(p, n * sizeof(T), alignment());}
+
+        /**
+         returns the arena shared by this allocator's family
+         */
+        BlockArena& arena () const {
+            return *_arena;}
+
+        template <typename U>
+        bool operator == (const BlockAllocator<U, Align, Threshold>& that) const {
+            return _arena == that._arena;}
+
+        template <typename U>
+        bool operator != (const BlockAllocator<U, Align, Threshold>& that) const {
+            return _arena != that._arena;}};
+
+#endif // BlockAllocator_h
@@ -0,0 +1,258 @@
+// ------------------------
+// projects/deque/Channel.h
+// ------------------------
+
+#ifndef Channel_h
+#define Channel_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>            // assert
+#include <condition_variable> // condition_variable
+#include <cstddef>            // size_t
+#include <iterator>           // make_move_iterator
+#include <memory>             // allocator
+#include <mutex>              // mutex, lock_guard, unique_lock
+#include <utility>            // forward, move
+
+#include "Deque.h"
+
+// -------
+// Channel
+// -------
+
+/**
+ a bounded FIFO for many producer and many consumer threads
+ the lock is held only to move elements in or out of a MyDeque, once per batch
+ for push_n and pop_n; a thread parks on a condition variable only when the
+ channel is full (producers) or empty (consumers), and is notified only if
+ someone is parked
+ the deque keeps an emptied inner array for reuse, so a channel in steady state
+ doesn't allocate
+ close() ends it: pushes fail from then on, pops drain what's left and then fail
+ */
+template <typename T, typename A = std::allocator<T> >
+class Channel {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T                                   value_type;
+        typedef typename MyDeque<T, A>::size_type   size_type;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        mutable std::mutex      _m;
+        std::condition_variable _notFull;
+        std::condition_variable _notEmpty;
+        MyDeque<T, A>           _q;
+        const size_type         _capacity;
+        size_type               _parkedProducers;
+        size_type               _parkedConsumers;
+        bool                    _closed;
+
+        Channel (const Channel&);
+        Channel& operator = (const Channel&);
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return _q.size() <= _capacity;}
+
+        // ------
+        // notify
+        // ------
+
+        // wakes parked threads after the lock is let go, one per element or slot
+        static void notify (std::condition_variable& c, size_type parked, size_type n) {
+            if (!parked || !n)
+                return;
+            if ((n > 1) && (parked > 1))
+                c.notify_all();
+            else
+                c.notify_one();}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         constructs an open channel that holds at most capacity elements
+         */
+        explicit Channel (size_type capacity, const A& a = A()) :
+                _q (a),
+                _capacity (capacity),
+                _parkedProducers (0),
+                _parkedConsumers (0),
+                _closed (false) {
+            assert(capacity > 0);}
+
+        // -----
+        // close
+        // -----
+
+        /**
+         closes the channel and wakes every parked thread
+         */
+        void close () {
+            {
+            std::lock_guard<std::mutex> l(_m);
+            _closed = true;
+            }
+            _notFull.notify_all();
+            _notEmpty.notify_all();}
+
+        bool closed () const {
+            std::lock_guard<std::mutex> l(_m);
+            return _closed;}
+
+        // ----
+        // push
+        // ----
+
+        /**
+         appends v, parking while the channel is full
+         returns false, without appending, if the channel is closed
+         */
+        bool push (const T& v) {
+            return push_n(&v, &v + 1) == 1;}
+
+        /**
+         moves v in, parking while the channel is full
+         returns false, leaving v alone, if the channel is closed
+         */
+        bool push (T&& v) {
+            return push_n(std::make_move_iterator(&v), std::make_move_iterator(&v + 1)) == 1;}
+
+        /**
+         appends [b, e), as many as fit per lock, parking while the channel is full
+         move iterators move the elements in instead of copying them
+         returns the number appended, short only if the channel was closed
+         */
+        template <typename I>
+        size_type push_n (I b, I e) {
+            size_type n = 0;
+            while (b != e) {
+                size_type k      = 0;
+                size_type parked = 0;
+                {
+                std::unique_lock<std::mutex> l(_m);
+                while (!_closed && (_q.size() == _capacity)) {
+                    ++_parkedProducers;
+                    _notFull.wait(l);
+                    --_parkedProducers;}
+                if (_closed)
+                    return n;
+                while ((b != e) && (_q.size() < _capacity)) {
+                    _q.push_back(*b);
+                    ++b;
+                    ++k;}
+                parked = _parkedConsumers;
+                assert(valid());
+                }
+                notify(_notEmpty, parked, k);
+                n += k;}
+            return n;}
+
+        /**
+         appends v if there's room and the channel is open, never parks
+         */
+        bool try_push (const T& v) {
+            return try_put(v);}
+
+        /**
+         moves v in if there's room and the channel is open, never parks
+         leaves v alone otherwise
+         */
+        bool try_push (T&& v) {
+            return try_put(std::move(v));}
+
+    private:
+        template <typename V>
+        bool try_put (V&& v) {
+            size_type parked;
+            {
+            std::lock_guard<std::mutex> l(_m);
+            if (_closed || (_q.size() == _capacity))
+                return false;
+            _q.push_back(std::forward<V>(v));
+            parked = _parkedConsumers;
+            }
+            notify(_notEmpty, parked, 1);
+            return true;}
+
+    public:
+        // ---
+        // pop
+        // ---
+
+        /**
+         removes the front element into v, parking while the channel is empty
+         returns false once the channel is closed and drained
+         */
+        bool pop (T& v) {
+            return pop_n(&v, 1) == 1;}
+
+        /**
+         moves up to max front elements into out under one lock, parking until
+         there's at least one
+         returns the number removed, 0 once the channel is closed and drained
+         */
+        template <typename O>
+        size_type pop_n (O out, size_type max) {
+            assert(max > 0);
+            size_type k = 0;
+            size_type parked;
+            {
+            std::unique_lock<std::mutex> l(_m);
+            while (!_closed && _q.empty()) {
+                ++_parkedConsumers;
+                _notEmpty.wait(l);
+                --_parkedConsumers;}
+            while ((k < max) && !_q.empty()) {
+                *out = std::move(_q.front());
+                ++out;
+                _q.pop_front();
+                ++k;}
+            parked = _parkedProducers;
+            }
+            notify(_notFull, parked, k);
+            return k;}
+
+        /**
+         removes the front element into v if there is one, never parks
+         */
+        bool try_pop (T& v) {
+            size_type parked;
+            {
+            std::lock_guard<std::mutex> l(_m);
+            if (_q.empty())
+                return false;
+            v = std::move(_q.front());
+            _q.pop_front();
+            parked = _parkedProducers;
+            }
+            notify(_notFull, parked, 1);
+            return true;}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            std::lock_guard<std::mutex> l(_m);
+            return _q.size();}
+
+        size_type capacity () const {
+            return _capacity;}};
+
+#endif // Channel_h
@@ -0,0 +1,327 @@
+// --------------------------------
+// projects/deque/CompressedDeque.h
+// --------------------------------
+
+#ifndef CompressedDeque_h
+#define CompressedDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>   // copy, fill
+#include <bit>         // bit_width
+#include <cassert>     // assert
+#include <cstddef>     // size_t
+#include <memory>      // allocator, allocator_traits
+#include <stdexcept>   // out_of_range
+#include <stdint.h>    // uint8_t, uint64_t
+#include <type_traits> // is_unsigned
+
+#include "Deque.h"
+
+// ---------------
+// CompressedDeque
+// ---------------
+
+/**
+ a FIFO of unsigned integers (ids, timestamps) that mostly grow by a little
+ elements go through three parts: a decoded head block that pops come from,
+ packed blocks in a MyDeque, and a raw tail block that pushes go to
+ a packed block holds blockSize values as a header (the first value and a bit
+ width, the count is always blockSize) and the blockSize - 1 differences between
+ neighbours, bit-packed at that width into 64-bit words; differences wrap
+ around, so any sequence works, it just packs worse where it doesn't grow by a
+ little
+ push_back and pop_front touch only the ends, operator [] decodes at most one
+ block, up to the element
+ */
+template <typename T = uint64_t, typename A = std::allocator<T> >
+class CompressedDeque {
+    static_assert(std::is_unsigned<T>::value && (sizeof(T) <= sizeof(uint64_t)),
+                  "CompressedDeque holds unsigned integers of at most 64 bits");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T                                                       value_type;
+        typedef std::size_t                                             size_type;
+        typedef typename std::allocator_traits<A>::template rebind_alloc<uint64_t> word_allocator_type;
+        typedef std::allocator_traits<word_allocator_type>              word_traits;
+
+        static const size_type blockSize = 128;                         // values per block
+
+    private:
+        // -----
+        // Block
+        // -----
+
+        struct Block {
+            T         first;
+            uint8_t   width;    // bits per difference, 0 to 64
+            uint64_t* words;    // the blockSize - 1 differences, 0 if width is 0
+        };
+
+        typedef typename std::allocator_traits<A>::template rebind_alloc<Block> block_allocator_type;
+
+        // ----
+        // data
+        // ----
+
+        word_allocator_type                     _a;
+        MyDeque<Block, block_allocator_type>    _blocks;    // full blocks, between head and tail
+        T                                       _head[blockSize];
+        size_type                               _hb;        // head is [_hb, _he)
+        size_type                               _he;
+        T                                       _tail[blockSize];
+        size_type                               _tn;        // tail is [0, _tn)
+        size_type                               _words;     // 64-bit words allocated by all blocks
+
+        CompressedDeque (const CompressedDeque&);
+        CompressedDeque& operator = (const CompressedDeque&);
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (_hb <= _he) && (_he <= blockSize) && (_tn < blockSize) &&
+                   ((_hb < _he) || (_blocks.empty() && (_tn == 0)));}
+
+        // -----
+        // words
+        // -----
+
+        static size_type words (uint8_t width) {
+            return ((blockSize - 1) * width + 63) / 64;}
+
+        // ----
+        // pack
+        // ----
+
+        /**
+         packs blockSize values into a new block
+         */
+        Block pack (const T* v) {
+            T diff[blockSize - 1];
+            T all = 0;
+            for (size_type i = 1; i != blockSize; ++i)
+                all |= diff[i - 1] = T(v[i] - v[i - 1]);
+            Block b;
+            b.first = v[0];
+            b.width = uint8_t(std::bit_width(uint64_t(all)));
+            b.words = 0;
+            const size_type n = words(b.width);
+            if (n == 0)
+                return b;
+            b.words = word_traits::allocate(_a, n);
+            std::fill(b.words, b.words + n, uint64_t(0));
+            _words += n;
+            for (size_type i = 0; i != blockSize - 1; ++i) {
+                const size_type p   = i * b.width;
+                const size_type off = p % 64;
+                b.words[p / 64] |= uint64_t(diff[i]) << off;
+                if (off + b.width > 64)
+                    b.words[p / 64 + 1] |= uint64_t(diff[i]) >> (64 - off);}
+            return b;}
+
+        // ------
+        // unpack
+        // ------
+
+        /**
+         decodes the first n values of b into v
+         */
+        static void unpack (const Block& b, T* v, size_type n) {
+            assert((n > 0) && (n <= blockSize));
+            const uint64_t mask = (b.width == 64) ? ~uint64_t(0) : (uint64_t(1) << b.width) - 1;
+            T x = v[0] = b.first;
+            for (size_type i = 1; i != n; ++i) {
+                if (b.width) {
+                    const size_type p   = (i - 1) * b.width;
+                    const size_type off = p % 64;
+                    uint64_t d = b.words[p / 64] >> off;
+                    if (off + b.width > 64)
+                        d |= b.words[p / 64 + 1] << (64 - off);
+                    x += T(d & mask);}
+                v[i] = x;}}
+
+        /**
+         decodes the k-th value of b, summing the first k differences
+         */
+        static T value (const Block& b, size_type k) {
+            assert(k < blockSize);
+            T x = b.first;
+            if (b.width == 0)
+                return x;
+            const uint64_t mask = (b.width == 64) ? ~uint64_t(0) : (uint64_t(1) << b.width) - 1;
+            for (size_type i = 0, p = 0; i != k; ++i, p += b.width) {
+                const size_type off = p % 64;
+                uint64_t d = b.words[p / 64] >> off;
+                if (off + b.width > 64)
+                    d |= b.words[p / 64 + 1] << (64 - off);
+                x += T(d & mask);}
+            return x;}
+
+        void free (const Block& b) {
+            const size_type n = words(b.width);
+            if (n) {
+                word_traits::deallocate(_a, b.words, n);
+                _words -= n;}}
+
+        // ------
+        // refill
+        // ------
+
+        /**
+         decodes the front packed block into the head, or moves the tail there
+         if there isn't one
+         */
+        void refill () {
+            assert(_hb == _he);
+            if (!_blocks.empty()) {
+                unpack(_blocks.front(), _head, blockSize);
+                free(_blocks.front());
+                _blocks.pop_front();
+                _he = blockSize;}
+            else {
+                std::copy(_tail, _tail + _tn, _head);
+                _he = _tn;
+                _tn = 0;}
+            _hb = 0;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        explicit CompressedDeque (const A& a = A()) :
+                _a (a),
+                _blocks (block_allocator_type(a)),
+                _hb (0),
+                _he (0),
+                _tn (0),
+                _words (0)
+            {}
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~CompressedDeque () {
+            clear();}
+
+        // -----------
+        // operator []
+        // -----------
+
+        /**
+         returns the index-th value, decoding at most one block
+         */
+        T operator [] (size_type index) const {
+            assert(index < size());
+            const size_type h = _he - _hb;
+            if (index < h)
+                return _head[_hb + index];
+            index -= h;
+            if (index < _blocks.size() * blockSize)
+                return value(_blocks[index / blockSize], index % blockSize);
+            return _tail[index - _blocks.size() * blockSize];}
+
+        /**
+         throws out_of_range if index isn't less than size()
+         */
+        T at (size_type index) const {
+            if (index >= size())
+                throw std::out_of_range("CompressedDeque::at index out of range");
+            return (*this)[index];}
+
+        // -----
+        // front
+        // -----
+
+        T front () const {
+            assert(!empty());
+            return _head[_hb];}
+
+        T back () const {
+            assert(!empty());
+            if (_tn)
+                return _tail[_tn - 1];
+            if (!_blocks.empty())
+                return value(_blocks.back(), blockSize - 1);
+            return _head[_he - 1];}
+
+        // ---------
+        // push_back
+        // ---------
+
+        /**
+         appends v to the tail, packing the tail into a block once it's full
+         if packing throws, nothing changes
+         */
+        void push_back (T v) {
+            _tail[_tn] = v;
+            if (_hb == _he) {
+                ++_tn;
+                refill();}
+            else if (_tn + 1 < blockSize)
+                ++_tn;
+            else {
+                const Block b = pack(_tail);
+                try {
+                    _blocks.push_back(b);}
+                catch (...) {
+                    free(b);
+                    throw;}
+                _tn = 0;}
+            assert(valid());}
+
+        // ---------
+        // pop_front
+        // ---------
+
+        /**
+         removes the front value, decoding the next block once the head is used up
+         */
+        void pop_front () {
+            assert(!empty());
+            if (++_hb == _he)
+                refill();
+            assert(valid());}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            while (!_blocks.empty()) {
+                free(_blocks.back());
+                _blocks.pop_back();}
+            _hb = _he = _tn = 0;}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return (_he - _hb) + _blocks.size() * blockSize + _tn;}
+
+        bool empty () const {
+            return _hb == _he;}
+
+        /**
+         returns the number of packed blocks
+         */
+        size_type blocks () const {
+            return _blocks.size();}
+
+        /**
+         returns the bytes in use: this object, the block headers and the packed words
+         */
+        size_type bytes () const {
+            return sizeof(*this) + _blocks.size() * sizeof(Block) + _words * sizeof(uint64_t);}};
+
+#endif // CompressedDeque_h
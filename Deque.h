@@ -11,14 +11,23 @@
 // includes
 // --------
 
-#include <algorithm> // copy, equal, lexicographical_compare, max, swap
+#include <algorithm> // copy, equal, lexicographical_compare, lower_bound, max, rotate, sort, stable_sort, swap
+#include <bit>       // countr_zero, popcount
 #include <cassert>   // assert
-#include <iterator>  // iterator, bidirectional_iterator_tag
-#include <memory>    // allocator
+#include <cstddef>   // ptrdiff_t, size_t
+#include <stdint.h>  // uint64_t
+#include <exception> // exception_ptr, current_exception, rethrow_exception
+#include <functional> // less
+#include <iterator>  // iterator, random_access_iterator_tag, make_move_iterator
+#include <memory>    // allocator, allocator_traits
 #include <stdexcept> // out_of_range
-#include <utility>   // !=, <=, >, >=
+#include <thread>    // thread
+#include <utility>   // !=, <=, >, >=, move
+#include <vector>    // vector
 #include <iostream> 
 
+#include "DequeTrace.h" // DequeTraceWriter, DEQUE_TRACE_OP
+
 // -----
 // using
 // -----
@@ -37,7 +46,7 @@ template <typename A, typename BI>
 BI destroy (A& a, BI b, BI e) {
     while (b != e) {
         --e;
-        a.destroy(&*e);}
+        std::allocator_traits<A>::destroy(a, &*e);}
     return b;}
 
 // ------------------
@@ -49,7 +58,7 @@ BI uninitialized_copy (A& a, II b, II e, BI x) {
     BI p = x;
     try {
         while (b != e) {
-            a.construct(&*x, *b);
+            std::allocator_traits<A>::construct(a, &*x, *b);
             ++b;
             ++x;}}
     catch (...) {
@@ -66,7 +75,7 @@ BI uninitialized_fill (A& a, BI b, BI e, const U& v) {
     BI p = b;
     try {
         while (b != e) {
-            a.construct(&*b, v);
+            std::allocator_traits<A>::construct(a, &*b, v);
             ++b;}}
     catch (...) {
         destroy(a, p, b);
@@ -85,20 +94,22 @@ class MyDeque {
         // --------
 
         typedef A                                        allocator_type;
-        typedef typename allocator_type::value_type      value_type;
+        typedef std::allocator_traits<allocator_type>    alloc_traits;
+        typedef typename alloc_traits::value_type        value_type;
 
-        typedef typename allocator_type::size_type       size_type;
-        typedef typename allocator_type::difference_type difference_type;
+        typedef typename alloc_traits::size_type         size_type;
+        typedef typename alloc_traits::difference_type   difference_type;
 
-        typedef typename allocator_type::pointer         pointer;
-        typedef typename allocator_type::const_pointer   const_pointer;
+        typedef typename alloc_traits::pointer           pointer;
+        typedef typename alloc_traits::const_pointer     const_pointer;
 
-        typedef typename allocator_type::reference       reference;
-        typedef typename allocator_type::const_reference const_reference;
+        typedef value_type&                              reference;
+        typedef const value_type&                        const_reference;
 
         // need allocator_type rebinded for a pointer of pointers (point to outer array)
-        typedef typename allocator_type::template rebind<T*>::other oa_allocator_type;  // oa - outer array
-        typedef typename oa_allocator_type::pointer                 oa_pointer; // pointer to oa
+        typedef typename alloc_traits::template rebind_alloc<T*> oa_allocator_type;  // oa - outer array
+        typedef std::allocator_traits<oa_allocator_type>         oa_traits;
+        typedef typename oa_traits::pointer                      oa_pointer; // pointer to oa
 
     public:
         // -----------
@@ -138,21 +149,39 @@ class MyDeque {
         // <your data> DONE
 
         allocator_type _a; // inner array allocator
-        pointer _dFront; // pointer to very front of deque
-        pointer _dBack; // pointer to very back of deque + 1
-        pointer _b; // pointer to beginning of actual data
-        pointer _e; // pointer to end of actual data + 1
-        pointer _thisBack; // pointer to back of current inner array
-        pointer dF_e; // pointer to _b + s NOTE could be out of bounds!! only used to determine _e
-    
         oa_allocator_type _oa; // outer array allocator
+
         oa_pointer _oaFront; // pointer to front of outer array
         oa_pointer _oaBack; // pointer to back of outer array + 1
+        oa_pointer _bArray; // slot of the inner array holding _b
+        oa_pointer _eArray; // slot of the inner array holding _e, slots outside [_bArray, _eArray] are 0
+
+        pointer _b; // pointer to beginning of actual data
+        pointer _e; // pointer to end of actual data + 1, never the end of its inner array
+        pointer _spare; // an emptied inner array kept for the next one needed, or 0
+
+        oa_pointer _next; // outer array being filled a few slots at a time in incremental mode, or 0
+        size_type _nextSize; // of _next
+        difference_type _nextShift; // slot p - _oaFront of the outer array is slot p - _oaFront + _nextShift of _next
+        size_type _copied; // slots of _next filled so far
+        bool _incremental; // grow the outer array a few slots per push and pop, not all at once
 
         size_type dSize; // number of elements
-        size_type numArray; // number of inner arrays
-        size_type sizeArray; // size of inner arrays
+
+        static pointer _nullArray; // outer array slot for iterators of a deque that never allocated
+
+        #ifdef DEQUE_DEBUG
+        size_type _gen; // bumped whenever the storage changes hands, iterators remember it
+        #endif
+
+        #ifdef DEQUE_TRACE
+        DequeTraceWriter* _trace; // where public operations are recorded, 0 if nowhere
+        #endif
  
+    public:
+        static const size_type sizeShift = 6;                         // log2 of sizeArray
+        static const size_type sizeArray = size_type(1) << sizeShift; // size of inner arrays
+
     private:
         // -----
         // valid
@@ -160,12 +189,21 @@ class MyDeque {
 
         bool valid () const {
             // <your code> DONE
-            return (!_dFront && !_dBack && !_b && !_e && !_oaFront && !_oaBack) || ((_dFront <= _b) && (_b <= _e) && (_e <= _dBack));}
+            if (!_oaFront)
+                return !_oaBack && !_bArray && !_eArray && !_b && !_e && !dSize;
+            return (_oaFront <= _bArray) && (_bArray <= _eArray) && (_eArray < _oaBack) &&
+                   (*_bArray <= _b) && (_b < *_bArray + sizeArray) &&
+                   (*_eArray <= _e) && (_e < *_eArray + sizeArray) &&
+                   ((_bArray != _eArray) || (_b <= _e));}
 
         // returns the size of the outer array
         size_type oaSize () const {
             return _oaBack - _oaFront;
-            }  
+            }
+
+        // returns the offset of the first element within its inner array
+        size_type frontOffset () const {
+            return _b - *_bArray;}
 
     public:
         // --------
@@ -173,12 +211,14 @@ class MyDeque {
         // --------
 
         class iterator {
+            friend class MyDeque;
+
             public:
                 // --------
                 // typedefs
                 // --------
 
-                typedef std::bidirectional_iterator_tag   iterator_category;
+                typedef std::random_access_iterator_tag   iterator_category;
                 typedef typename MyDeque::value_type      value_type;
                 typedef typename MyDeque::difference_type difference_type;
                 typedef typename MyDeque::pointer         pointer;
@@ -195,7 +235,10 @@ class MyDeque {
                  */
                 friend bool operator == (const iterator& lhs, const iterator& rhs) {
                     // <your code> DONE
-                    return (lhs._d == rhs._d) &&(lhs._i == rhs._i);}
+                    #ifdef DEQUE_DEBUG
+                    assert(lhs._d == rhs._d);
+                    #endif
+                    return lhs._p == rhs._p;}
 
                 /**
                  * <your documentation> DONE
@@ -226,16 +269,43 @@ class MyDeque {
                 friend iterator operator - (iterator lhs, difference_type rhs) {
                     return lhs -= rhs;}
 
+                /**
+                 returns the number of steps from rhs to lhs
+                 */
+                friend difference_type operator - (const iterator& lhs, const iterator& rhs) {
+                    #ifdef DEQUE_DEBUG
+                    assert(lhs._d == rhs._d);
+                    #endif
+                    if (lhs._n == rhs._n)
+                        return lhs._p - rhs._p;
+                    return (lhs._n - rhs._n - 1) * difference_type(sizeArray) + (lhs._p - *lhs._n) + (*rhs._n + sizeArray - rhs._p);}
+
+                // ----------
+                // operator <
+                // ----------
+
+                /**
+                 bool return true if lhs comes before rhs
+                 */
+                friend bool operator < (const iterator& lhs, const iterator& rhs) {
+                    #ifdef DEQUE_DEBUG
+                    assert(lhs._d == rhs._d);
+                    #endif
+                    return (lhs._n < rhs._n) || ((lhs._n == rhs._n) && (lhs._p < rhs._p));}
+
             private:
                 // ----
                 // data
                 // ----
 
                 // <your data> DONE
-                MyDeque* _d;
-                size_t _i; // index
-                pointer _p;
+                pointer    _p; // current element
+                oa_pointer _n; // inner array cursor, *_n is the inner array holding _p
 
+                #ifdef DEQUE_DEBUG
+                MyDeque*  _d;   // owner, to catch iterators of different deques being mixed
+                size_type _gen; // owner's generation when made, to catch use after reallocation
+                #endif
 
             private:
                 // -----
@@ -244,7 +314,32 @@ class MyDeque {
 
                 bool valid () const {
                     // <your code> DONE
-                    return _i >= 0;}
+                    #ifdef DEQUE_DEBUG
+                    return _d && (_gen == _d->_gen) && (index() >= 0) && (index() <= difference_type(_d->size()));
+                    #else
+                    return true;
+                    #endif
+                    }
+
+                #ifdef DEQUE_DEBUG
+                // returns the position in the owner, begin() is 0
+                difference_type index () const {
+                    if (!_d->_oaFront)
+                        return _p - pointer();
+                    return (_n - _d->_bArray) * difference_type(sizeArray) + (_p - *_n) - (_d->_b - *_d->_bArray);}
+                #endif
+
+                /**
+                 iterator at p, within the inner array *n, of deque d
+                 */
+                iterator (pointer p, oa_pointer n, MyDeque* d) :
+                        _p (p),
+                        _n (n) {
+                    #ifdef DEQUE_DEBUG
+                    _d   = d;
+                    _gen = d->_gen;
+                    #endif
+                    assert(valid());}
 
             public:
                 // -----------
@@ -253,15 +348,11 @@ class MyDeque {
 
                 /**
                  * <your documentation> DONE
-                 constructor
+                 constructor, iterator to the i-th element of d
                  */
-                iterator (MyDeque* d, size_t i) :
-                        _d (d),
-                        _i (i)  {
+                iterator (MyDeque* d, size_t i) {
                     // <your code> DONE 
-                    _p = (*_d)._b + _i;
-                    assert(valid());
-                }
+                    *this = d->begin() + i;}
 
                 // Default copy, destructor, and copy assignment.
                 // iterator (const iterator&);
@@ -278,9 +369,10 @@ class MyDeque {
                  */
                 reference operator * () const {
                     // <your code> DONE
-                    // dummy is just to be able to compile the skeleton, remove it
-                    // static value_type dummy;
-                    return (*_p);}
+                    #ifdef DEQUE_DEBUG
+                    assert(valid() && (index() < difference_type(_d->size())));
+                    #endif
+                    return *_p;}
 
                 // -----------
                 // operator ->
@@ -293,6 +385,16 @@ class MyDeque {
                 pointer operator -> () const {
                     return &**this;}
 
+                // -----------
+                // operator []
+                // -----------
+
+                /**
+                 ref to the element d steps away
+                 */
+                reference operator [] (difference_type d) const {
+                    return *(*this + d);}
+
                 // -----------
                 // operator ++
                 // -----------
@@ -303,7 +405,8 @@ class MyDeque {
                  */
                 iterator& operator ++ () {
                     // <your code> DONE
-                    ++_p;
+                    if (++_p == *_n + sizeArray)
+                        _p = *++_n;
                     assert(valid());
                     return *this;}
 
@@ -314,7 +417,6 @@ class MyDeque {
                 iterator operator ++ (int) {
                     iterator x = *this;
                     ++(*this);
-                    assert(valid());
                     return x;}
 
                 // -----------
@@ -327,6 +429,8 @@ class MyDeque {
                  */
                 iterator& operator -- () {
                     // <your code> DONE
+                    if (_p == *_n)
+                        _p = *--_n + sizeArray;
                     --_p;
                     assert(valid());
                     return *this;}
@@ -338,7 +442,6 @@ class MyDeque {
                 iterator operator -- (int) {
                     iterator x = *this;
                     --(*this);
-                    assert(valid());
                     return x;}
 
                 // -----------
@@ -347,11 +450,17 @@ class MyDeque {
 
                 /**
                  * <your documentation> DONE
-                move iterator + d steps
+                move iterator + d steps, only touching the outer array when leaving the inner array
                  */
                 iterator& operator += (difference_type d) {
                     // <your code> DONE
-                    _p += d;
+                    const difference_type o = (_p - *_n) + d;
+                    if ((o >= 0) && (o < difference_type(sizeArray)))
+                        _p += d;
+                    else {
+                        const difference_type n = (o >= 0) ? (o / difference_type(sizeArray)) : -((-o - 1) / difference_type(sizeArray)) - 1;
+                        _n += n;
+                        _p = *_n + (o - n * difference_type(sizeArray));}
                     assert(valid());
                     return *this;}
 
@@ -365,9 +474,7 @@ class MyDeque {
                  */
                 iterator& operator -= (difference_type d) {
                     // <your code> DONE
-                    _p -= d;
-                    assert(valid());
-                    return *this;}};
+                    return *this += -d;}};
 
     public:
         // --------------
@@ -375,12 +482,14 @@ class MyDeque {
         // --------------
 
         class const_iterator {
+            friend class MyDeque;
+
             public:
                 // --------
                 // typedefs
                 // --------
 
-                typedef std::bidirectional_iterator_tag   iterator_category;
+                typedef std::random_access_iterator_tag   iterator_category;
                 typedef typename MyDeque::value_type      value_type;
                 typedef typename MyDeque::difference_type difference_type;
                 typedef typename MyDeque::const_pointer   pointer;
@@ -397,7 +506,10 @@ class MyDeque {
                  */
                 friend bool operator == (const const_iterator& lhs, const const_iterator& rhs) {
                     // <your code> DONE
-                    return (lhs._d == rhs._d) &&(lhs._i == rhs._i);}
+                    #ifdef DEQUE_DEBUG
+                    assert(lhs._d == rhs._d);
+                    #endif
+                    return lhs._p == rhs._p;}
 
                 /**
                  * <your documentation> DONE
@@ -412,7 +524,7 @@ class MyDeque {
 
                 /**
                  * <your documentation> DONE
-                 returns iterator + rhs
+                 returns const_iterator + rhs
                  */
                 friend const_iterator operator + (const_iterator lhs, difference_type rhs) {
                     return lhs += rhs;}
@@ -423,21 +535,48 @@ class MyDeque {
 
                 /**
                  * <your documentation> DONE
-                 returns iterator - rhs
+                 returns const_iterator - rhs
                  */
                 friend const_iterator operator - (const_iterator lhs, difference_type rhs) {
                     return lhs -= rhs;}
 
+                /**
+                 returns the number of steps from rhs to lhs
+                 */
+                friend difference_type operator - (const const_iterator& lhs, const const_iterator& rhs) {
+                    #ifdef DEQUE_DEBUG
+                    assert(lhs._d == rhs._d);
+                    #endif
+                    if (lhs._n == rhs._n)
+                        return lhs._p - rhs._p;
+                    return (lhs._n - rhs._n - 1) * difference_type(sizeArray) + (lhs._p - *lhs._n) + (*rhs._n + sizeArray - rhs._p);}
+
+                // ----------
+                // operator <
+                // ----------
+
+                /**
+                 bool return true if lhs comes before rhs
+                 */
+                friend bool operator < (const const_iterator& lhs, const const_iterator& rhs) {
+                    #ifdef DEQUE_DEBUG
+                    assert(lhs._d == rhs._d);
+                    #endif
+                    return (lhs._n < rhs._n) || ((lhs._n == rhs._n) && (lhs._p < rhs._p));}
+
             private:
                 // ----
                 // data
                 // ----
 
                 // <your data> DONE
-                const MyDeque* _d;
-                size_t _i; // index
-                pointer _p;
+                pointer    _p; // current element
+                oa_pointer _n; // inner array cursor, *_n is the inner array holding _p
 
+                #ifdef DEQUE_DEBUG
+                const MyDeque* _d;   // owner, to catch iterators of different deques being mixed
+                size_type      _gen; // owner's generation when made, to catch use after reallocation
+                #endif
 
             private:
                 // -----
@@ -446,7 +585,32 @@ class MyDeque {
 
                 bool valid () const {
                     // <your code> DONE
-                    return _i >= 0;}
+                    #ifdef DEQUE_DEBUG
+                    return _d && (_gen == _d->_gen) && (index() >= 0) && (index() <= difference_type(_d->size()));
+                    #else
+                    return true;
+                    #endif
+                    }
+
+                #ifdef DEQUE_DEBUG
+                // returns the position in the owner, begin() is 0
+                difference_type index () const {
+                    if (!_d->_oaFront)
+                        return _p - pointer();
+                    return (_n - _d->_bArray) * difference_type(sizeArray) + (_p - *_n) - (_d->_b - *_d->_bArray);}
+                #endif
+
+                /**
+                 const_iterator at p, within the inner array *n, of deque d
+                 */
+                const_iterator (pointer p, oa_pointer n, const MyDeque* d) :
+                        _p (p),
+                        _n (n) {
+                    #ifdef DEQUE_DEBUG
+                    _d   = d;
+                    _gen = d->_gen;
+                    #endif
+                    assert(valid());}
 
             public:
                 // -----------
@@ -455,16 +619,11 @@ class MyDeque {
 
                 /**
                  * <your documentation> DONE
-                 constructor
+                 constructor, const_iterator to the i-th element of d
                  */
-                const_iterator (/* <your arguments> DONE */ const MyDeque* d, size_t i) : 
-                        _d (d),
-                        _i (i),
-                        _p ((*_d)._b + _i)  
-                        {
+                const_iterator (const MyDeque* d, size_t i) {
                     // <your code> DONE 
-                    assert(valid());
-                }
+                    *this = d->begin() + i;}
 
                 // Default copy, destructor, and copy assignment.
                 // const_iterator (const const_iterator&);
@@ -481,8 +640,9 @@ class MyDeque {
                  */
                 reference operator * () const {
                     // <your code> DONE
-                    // dummy is just to be able to compile the skeleton, remove it
-                    // static value_type dummy;
+                    #ifdef DEQUE_DEBUG
+                    assert(valid() && (index() < difference_type(_d->size())));
+                    #endif
                     return *_p;}
 
                 // -----------
@@ -491,11 +651,21 @@ class MyDeque {
 
                 /**
                  * <your documentation> DONE
-                 member acces
+                 member access
                  */
                 pointer operator -> () const {
                     return &**this;}
 
+                // -----------
+                // operator []
+                // -----------
+
+                /**
+                 ref to the element d steps away
+                 */
+                reference operator [] (difference_type d) const {
+                    return *(*this + d);}
+
                 // -----------
                 // operator ++
                 // -----------
@@ -506,9 +676,8 @@ class MyDeque {
                  */
                 const_iterator& operator ++ () {
                     // <your code> DONE
-
-                    // THIS KILLS TWO OF MY DEQUE == TESTS???  SHOULD BE ++_p;
-                    ++_i;
+                    if (++_p == *_n + sizeArray)
+                        _p = *++_n;
                     assert(valid());
                     return *this;}
 
@@ -519,7 +688,6 @@ class MyDeque {
                 const_iterator operator ++ (int) {
                     const_iterator x = *this;
                     ++(*this);
-                    assert(valid());
                     return x;}
 
                 // -----------
@@ -532,18 +700,19 @@ class MyDeque {
                  */
                 const_iterator& operator -- () {
                     // <your code> DONE
+                    if (_p == *_n)
+                        _p = *--_n + sizeArray;
                     --_p;
                     assert(valid());
                     return *this;}
 
                 /**
                  * <your documentation> DONE
-                 post increment --
+                 post-increment --
                  */
                 const_iterator operator -- (int) {
                     const_iterator x = *this;
                     --(*this);
-                    assert(valid());
                     return x;}
 
                 // -----------
@@ -552,11 +721,17 @@ class MyDeque {
 
                 /**
                  * <your documentation> DONE
-                 move iterator + d steps
+                move const_iterator + d steps, only touching the outer array when leaving the inner array
                  */
                 const_iterator& operator += (difference_type d) {
                     // <your code> DONE
-                    _p += d;
+                    const difference_type o = (_p - *_n) + d;
+                    if ((o >= 0) && (o < difference_type(sizeArray)))
+                        _p += d;
+                    else {
+                        const difference_type n = (o >= 0) ? (o / difference_type(sizeArray)) : -((-o - 1) / difference_type(sizeArray)) - 1;
+                        _n += n;
+                        _p = *_n + (o - n * difference_type(sizeArray));}
                     assert(valid());
                     return *this;}
 
@@ -566,13 +741,484 @@ class MyDeque {
 
                 /**
                  * <your documentation> DONE
-                 move iterator - d steps
+                 move const_iterator - d steps
                  */
                 const_iterator& operator -= (difference_type d) {
-                    // <your code>
-                    _p -= d;
-                    assert(valid());
-                    return *this;}};
+                    // <your code> DONE
+                    return *this += -d;}};
+
+
+    private:
+        // --------
+        // position
+        // --------
+
+        /**
+         returns an iterator to the i-th element, in normal form: _p is within *_n
+         */
+        iterator position (size_type i) {
+            if (!_oaFront)
+                return iterator(pointer(), &_nullArray, this);
+            const size_type o = frontOffset() + i;
+            return iterator(_bArray[o / sizeArray] + o % sizeArray, _bArray + o / sizeArray, this);}
+
+        /**
+         returns a const iterator to the i-th element
+         */
+        const_iterator position (size_type i) const {
+            if (!_oaFront)
+                return const_iterator(pointer(), &_nullArray, this);
+            const size_type o = frontOffset() + i;
+            return const_iterator(_bArray[o / sizeArray] + o % sizeArray, _bArray + o / sizeArray, this);}
+
+        // -----------
+        // inner array
+        // -----------
+
+        // reuses the spare inner array if there is one
+        pointer allocate_array () {
+            if (_spare) {
+                pointer p = _spare;
+                _spare = 0;
+                return p;}
+            return alloc_traits::allocate(_a, sizeArray);}
+
+        // keeps p as the spare inner array if there isn't one, so a deque that
+        // pops an inner array empty at one end and fills one at the other doesn't
+        // go to the allocator every sizeArray elements
+        void deallocate_array (pointer p) {
+            if (!_spare)
+                _spare = p;
+            else
+                alloc_traits::deallocate(_a, p, sizeArray);}
+
+        // ---------
+        // outer map
+        // ---------
+
+        /**
+         gives a deque that never allocated an outer array with room for arrays
+         inner arrays, and one empty inner array in the middle of it
+         */
+        void create_map (size_type arrays) {
+            const size_type cap = max(size_type(8), arrays + 2);
+            _oaFront = oa_traits::allocate(_oa, cap);
+            _oaBack  = _oaFront + cap;
+            std::fill(_oaFront, _oaBack, pointer());
+            _bArray = _eArray = _oaFront + (cap - arrays) / 2;
+            *_bArray = allocate_array();
+            _b = _e = *_bArray;}
+
+        /**
+         makes sure there are k free slots before _bArray (front) or after _eArray (back)
+         recenters the inner arrays if the outer array is at most half full, otherwise
+         moves them to an outer array twice the size; elements never move
+         */
+        void reserve_map (bool front, size_type k = 1) {
+            if (front ? (size_type(_bArray - _oaFront) >= k) : (size_type(_oaBack - _eArray - 1) >= k))
+                return;
+            settle();
+            if (front ? (size_type(_bArray - _oaFront) >= k) : (size_type(_oaBack - _eArray - 1) >= k))
+                return;
+            const size_type used = _eArray - _bArray + 1;
+            const size_type cap  = oaSize();
+            oa_pointer nb;
+            if (2 * (used + k) <= cap) {
+                nb = _oaFront + (cap - used) / 2;
+                if (nb < _bArray)
+                    std::copy(_bArray, _eArray + 1, nb);
+                else
+                    std::copy_backward(_bArray, _eArray + 1, nb + used);
+                std::fill(_oaFront, nb, pointer());
+                std::fill(nb + used, _oaBack, pointer());}
+            else {
+                const size_type newCap = 2 * max(cap, used + k);
+                oa_pointer newFront = oa_traits::allocate(_oa, newCap);
+                std::fill(newFront, newFront + newCap, pointer());
+                nb = newFront + (newCap - used) / 2;
+                std::copy(_bArray, _eArray + 1, nb);
+                oa_traits::deallocate(_oa, _oaFront, cap);
+                _oaFront = newFront;
+                _oaBack  = newFront + newCap;}
+            _bArray = nb;
+            _eArray = nb + used - 1;
+            #ifdef DEQUE_DEBUG
+            ++_gen;
+            #endif
+            }
+
+        /**
+         destroys every element and gives back every inner array and the outer array
+         */
+        void release () {
+            if (!_oaFront)
+                return;
+            settle();
+            destroy(_a, begin(), end());
+            for (oa_pointer p = _bArray; p <= _eArray; ++p)
+                deallocate_array(*p);
+            if (_spare)
+                alloc_traits::deallocate(_a, _spare, sizeArray);
+            oa_traits::deallocate(_oa, _oaFront, oaSize());
+            _oaFront = _oaBack = _bArray = _eArray = 0;
+            _b = _e = 0;
+            _spare = 0;
+            dSize = 0;}
+
+        /**
+         gives back the outer array and the inner arrays still in it, for a deque
+         whose elements have all been destroyed or handed to another deque
+         leaves the deque as if default constructed
+         */
+        void abandon () {
+            if (!_oaFront)
+                return;
+            settle();
+            for (oa_pointer p = _bArray; p <= _eArray; ++p)
+                if (*p)
+                    alloc_traits::deallocate(_a, *p, sizeArray);
+            if (_spare)
+                alloc_traits::deallocate(_a, _spare, sizeArray);
+            oa_traits::deallocate(_oa, _oaFront, oaSize());
+            _oaFront = _oaBack = _bArray = _eArray = 0;
+            _b = _e = 0;
+            _spare = 0;
+            dSize = 0;
+            #ifdef DEQUE_DEBUG
+            ++_gen;
+            #endif
+            }
+
+        // ------------------
+        // incremental growth
+        // ------------------
+
+        /**
+         starts filling _next, twice the size of the outer array, or the same
+         size if at most half of it is in use, with the inner arrays centered
+         */
+        void start_next () {
+            const size_type used = _eArray - _bArray + 1;
+            const size_type cap  = oaSize();
+            _nextSize  = (2 * used <= cap) ? cap : 2 * cap;
+            _next      = oa_traits::allocate(_oa, _nextSize);
+            _nextShift = difference_type((_nextSize - used) / 2) - (_bArray - _oaFront);
+            _copied    = 0;}
+
+        /**
+         fills k more slots of _next from the outer array, and switches to it once it's full
+         */
+        void migrate (size_type k) {
+            const difference_type cap = oaSize();
+            for (; k && (_copied != _nextSize); --k, ++_copied) {
+                const difference_type p = difference_type(_copied) - _nextShift;
+                _next[_copied] = ((p >= 0) && (p < cap)) ? _oaFront[p] : pointer();}
+            if (_copied != _nextSize)
+                return;
+            _bArray  = _next + (_bArray - _oaFront) + _nextShift;
+            _eArray  = _next + (_eArray - _oaFront) + _nextShift;
+            oa_traits::deallocate(_oa, _oaFront, cap);
+            _oaFront = _next;
+            _oaBack  = _next + _nextSize;
+            _next    = 0;
+            _copied  = 0;
+            #ifdef DEQUE_DEBUG
+            ++_gen;
+            #endif
+            }
+
+        /**
+         copies slot p of the outer array, just written, to _next if _next is filled that far
+         */
+        void mirror (oa_pointer p) {
+            if (!_next)
+                return;
+            const difference_type j = (p - _oaFront) + _nextShift;
+            assert((j >= 0) && (j < difference_type(_nextSize)));
+            if (size_type(j) < _copied)
+                _next[j] = *p;}
+
+        /**
+         finishes filling _next, for the operations that move many slots at once
+         */
+        void settle () {
+            if (_next)
+                migrate(_nextSize);}
+
+        /**
+         after a push or pop in incremental mode: fills 4 more slots of _next, or
+         starts a new one once either end of the outer array is down to less than
+         an eighth of it free, long before either runs out
+         */
+        void step () {
+            if (_next)
+                migrate(4);
+            else if (_incremental && _oaFront &&
+                     (8 * std::min(size_type(_bArray - _oaFront), size_type(_oaBack - _eArray - 1)) < oaSize()))
+                start_next();}
+
+        // ---------
+        // move_back
+        // ---------
+
+        /**
+         move-constructs [b, e) at the back, an inner array's worth at a time
+         */
+        void move_back (pointer b, pointer e) {
+            if (!_oaFront && (b != e))
+                create_map(1);
+            while (b != e) {
+                const size_type room = (*_eArray + sizeArray) - _e;
+                const size_type n    = std::min(room, size_type(e - b));
+                if (n == room) {
+                    // fills the last inner array, so the next one has to be there first
+                    reserve_map(false);
+                    _eArray[1] = allocate_array();}
+                try {
+                    uninitialized_copy(_a, std::make_move_iterator(b), std::make_move_iterator(b + n), _e);}
+                catch (...) {
+                    if (n == room) {
+                        deallocate_array(_eArray[1]);
+                        _eArray[1] = 0;}
+                    throw;}
+                b     += n;
+                dSize += n;
+                if (n != room)
+                    _e += n;
+                else {
+                    ++_eArray;
+                    mirror(_eArray);
+                    _e = *_eArray;}}
+            #ifdef DEQUE_DEBUG
+            ++_gen;
+            #endif
+            }
+
+        /**
+         move-constructs [b, e) at the front, an inner array's worth at a time
+         */
+        void move_front (pointer b, pointer e) {
+            if (!_oaFront && (b != e))
+                create_map(1);
+            while (b != e) {
+                const size_type room = _b - *_bArray;
+                if (room) {
+                    const size_type n = std::min(room, size_type(e - b));
+                    uninitialized_copy(_a, std::make_move_iterator(e - n), std::make_move_iterator(e), _b - n);
+                    _b    -= n;
+                    e     -= n;
+                    dSize += n;}
+                else {
+                    const size_type n = std::min(sizeArray, size_type(e - b));
+                    reserve_map(true);
+                    _bArray[-1] = allocate_array();
+                    try {
+                        uninitialized_copy(_a, std::make_move_iterator(e - n), std::make_move_iterator(e), _bArray[-1] + (sizeArray - n));}
+                    catch (...) {
+                        deallocate_array(_bArray[-1]);
+                        _bArray[-1] = 0;
+                        throw;}
+                    --_bArray;
+                    mirror(_bArray);
+                    _b     = *_bArray + (sizeArray - n);
+                    e     -= n;
+                    dSize += n;}}
+            #ifdef DEQUE_DEBUG
+            ++_gen;
+            #endif
+            }
+
+        /**
+         moves every element of that to the back of this deque, one contiguous run
+         at a time, and clears that
+         */
+        void move_back (MyDeque& that) {
+            for (size_type s = 0; s != that.segments(); ++s) {
+                std::pair<pointer, pointer> r = that.segment(s);
+                move_back(r.first, r.second);}
+            that.clear();}
+
+        /**
+         moves every element of that to the front of this deque, one contiguous run
+         at a time, and clears that
+         */
+        void move_front (MyDeque& that) {
+            for (size_type s = that.segments(); s-- != 0; ) {
+                std::pair<pointer, pointer> r = that.segment(s);
+                move_front(r.first, r.second);}
+            that.clear();}
+
+        // ----------
+        // sort_merge
+        // ----------
+
+        /**
+         stable in-place merge of the sorted runs [b, m) and [m, e)
+         moves at most bufSize elements through the raw scratch space buf;
+         runs that don't fit are split and rotated until their pieces do
+         */
+        template <typename C>
+        void sort_merge (iterator b, iterator m, iterator e, pointer buf, size_type bufSize, C c) {
+            const size_type len1 = m - b;
+            const size_type len2 = e - m;
+            if ((len1 == 0) || (len2 == 0) || !c(*m, *(m - 1)))
+                return;
+            if ((len1 <= bufSize) || (len2 <= bufSize)) {
+                // if c throws, what's still parked in buf goes back into the
+                // moved-from places, [b, m) going forward, [m, e) going backward
+                if (len1 <= len2) {
+                    // forward merge, left run parked in buf
+                    pointer bufE = uninitialized_copy(_a, make_move_iterator(b), make_move_iterator(m), buf);
+                    pointer p = buf;
+                    try {
+                        while ((p != bufE) && (m != e)) {
+                            if (c(*m, *p)) {
+                                *b = std::move(*m);
+                                ++m;}
+                            else {
+                                *b = std::move(*p);
+                                ++p;}
+                            ++b;}}
+                    catch (...) {
+                        std::move(p, bufE, b);
+                        destroy(_a, buf, bufE);
+                        throw;}
+                    std::move(p, bufE, b);
+                    destroy(_a, buf, bufE);}
+                else {
+                    // backward merge, right run parked in buf
+                    pointer bufE = uninitialized_copy(_a, make_move_iterator(m), make_move_iterator(e), buf);
+                    pointer p = bufE;
+                    try {
+                        while ((p != buf) && (m != b)) {
+                            if (c(*(p - 1), *(m - 1))) {
+                                *(e - 1) = std::move(*(m - 1));
+                                --m;}
+                            else {
+                                *(e - 1) = std::move(*(p - 1));
+                                --p;}
+                            --e;}}
+                    catch (...) {
+                        std::move_backward(buf, p, e);
+                        destroy(_a, buf, bufE);
+                        throw;}
+                    std::move_backward(buf, p, e);
+                    destroy(_a, buf, bufE);}
+                return;}
+            iterator cut1 = b;
+            iterator cut2 = m;
+            if (len1 > len2) {
+                cut1 += len1 / 2;
+                cut2 = lower_bound(m, e, *cut1, c);}
+            else {
+                cut2 += len2 / 2;
+                cut1 = upper_bound(b, m, *cut2, c);}
+            iterator mid = cut1 + (cut2 - m);
+            std::rotate(cut1, m, cut2);
+            sort_merge(b, cut1, mid, buf, bufSize, c);
+            sort_merge(mid, cut2, e, buf, bufSize, c);}
+
+        // ------------
+        // sort_workers
+        // ------------
+
+        /**
+         runs f(0) ... f(k - 1), one thread each, and rethrows the first exception
+         */
+        template <typename F>
+        static void sort_workers (size_type k, F f) {
+            std::vector<std::thread>        t;
+            std::vector<std::exception_ptr> x(k);
+            for (size_type i = 1; i < k; ++i)
+                t.push_back(std::thread([&f, &x, i] () {
+                    try {
+                        f(i);}
+                    catch (...) {
+                        x[i] = std::current_exception();}}));
+            try {
+                f(0);}
+            catch (...) {
+                x[0] = std::current_exception();}
+            for (size_type i = 0; i < t.size(); ++i)
+                t[i].join();
+            for (size_type i = 0; i < k; ++i)
+                if (x[i])
+                    std::rethrow_exception(x[i]);}
+
+        // ----------
+        // block_sort
+        // ----------
+
+        /**
+         sorts each inner array in place, one contiguous run of inner arrays per worker,
+         then merges the runs pairwise through a scratch buffer of about size() / 16 elements
+         workers of 0 means one per core, or just one below 65536 elements
+         */
+        template <typename C>
+        void block_sort (C c, bool stable, size_type workers) {
+            const size_type n = size();
+            if (n < 2)
+                return;
+
+            // run boundaries, one run per inner array
+            std::vector<size_type> runs(1, 0);
+            for (size_type i = min(n, sizeArray - frontOffset()); i < n; i += sizeArray)
+                runs.push_back(i);
+            runs.push_back(n);
+
+            if (!workers)
+                workers = (n < 65536) ? 1 : max(1u, std::thread::hardware_concurrency());
+            workers = min(workers, runs.size() - 1);
+
+            // whole inner arrays per worker
+            std::vector<size_type> chunks(1, 0);
+            for (size_type w = 1; w < workers; ++w)
+                chunks.push_back((runs.size() - 1) * w / workers);
+            chunks.push_back(runs.size() - 1);
+
+            const size_type bufSize = max(sizeArray, n / 16);
+            pointer buf = alloc_traits::allocate(_a, bufSize);
+            try {
+                iterator b = begin();
+                sort_workers(workers, [&] (size_type w) {
+                    pointer   slice      = buf + bufSize / workers * w;
+                    size_type sliceSize  = bufSize / workers;
+                    std::vector<size_type> r(runs.begin() + chunks[w], runs.begin() + chunks[w + 1] + 1);
+                    for (size_type i = 0; i + 1 < r.size(); ++i) {
+                        pointer p = &*(b + r[i]);
+                        if (stable)
+                            std::stable_sort(p, p + (r[i + 1] - r[i]), c);
+                        else
+                            std::sort(p, p + (r[i + 1] - r[i]), c);}
+                    while (r.size() > 2) {
+                        std::vector<size_type> s;
+                        for (size_type i = 0; i + 2 < r.size(); i += 2) {
+                            this->sort_merge(b + r[i], b + r[i + 1], b + r[i + 2], slice, sliceSize, c);
+                            s.push_back(r[i]);}
+                        if (r.size() % 2 == 0)
+                            s.push_back(r[r.size() - 2]);
+                        s.push_back(r.back());
+                        r.swap(s);}});
+
+                // merge the workers' runs, every pair of a level in parallel
+                std::vector<size_type> r;
+                for (size_type w = 0; w < chunks.size(); ++w)
+                    r.push_back(runs[chunks[w]]);
+                while (r.size() > 2) {
+                    const size_type pairs = (r.size() - 1) / 2;
+                    sort_workers(pairs, [&] (size_type i) {
+                        this->sort_merge(b + r[2 * i], b + r[2 * i + 1], b + r[2 * i + 2],
+                                         buf + bufSize / pairs * i, bufSize / pairs, c);});
+                    std::vector<size_type> s;
+                    for (size_type i = 0; i + 1 < r.size(); i += 2)
+                        s.push_back(r[i]);
+                    s.push_back(r.back());
+                    r.swap(s);}}
+            catch (...) {
+                alloc_traits::deallocate(_a, buf, bufSize);
+                throw;}
+            alloc_traits::deallocate(_a, buf, bufSize);
+            assert(valid());}
 
     public:
         // ------------
@@ -585,11 +1231,22 @@ class MyDeque {
          */
         explicit MyDeque (const allocator_type& a = allocator_type()) :
                 _a(a),
-                _oa() {
+                _oa(_a) {
             // <your code> DONE
-            _oaFront = _oaBack = 0; 
-            _dFront = _dBack = _b = _e = 0;
-            dSize = numArray = sizeArray = 0;
+            _oaFront = _oaBack = _bArray = _eArray = 0; 
+            _b = _e = 0;
+            _spare = 0;
+            _next = 0;
+            _nextSize = _copied = 0;
+            _nextShift = 0;
+            _incremental = false;
+            dSize = 0;
+            #ifdef DEQUE_DEBUG
+            _gen = 0;
+            #endif
+            #ifdef DEQUE_TRACE
+            _trace = 0;
+            #endif
             assert(valid());
         }
 
@@ -599,76 +1256,35 @@ class MyDeque {
          */
         explicit MyDeque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) :
                 _a(a),
-                _oa() {
+                _oa(_a) {
             // <your code>
-            // determine number of inner arrays required
+            _oaFront = _oaBack = _bArray = _eArray = 0; 
+            _b = _e = 0;
+            _spare = 0;
+            _next = 0;
+            _nextSize = _copied = 0;
+            _nextShift = 0;
+            _incremental = false;
+            dSize = 0;
+            #ifdef DEQUE_DEBUG
+            _gen = 0;
+            #endif
+            #ifdef DEQUE_TRACE
+            _trace = 0;
+            #endif
 
             // if size == 0, like the above constructor
-            if(s == 0) {
-                _oaFront = _oaBack = 0; 
-                _dFront = _dBack = _b = _e = 0;
-                dSize = 0;
-            }
-            else {
-                // determine number of inner arrays 
-                _oaFront = _oaBack = 0; 
-                _dFront = _dBack = _b = _e = 0;
-                size_type carry = 0;
-                sizeArray = 10;
-
-                if(s%sizeArray > 0)
-                    carry = 1;
-                numArray = s/sizeArray + carry; 
-                assert(numArray >= 1);
-
-                // allocate outer array
-                _oaFront = _oa.allocate(numArray);
-                _oaBack = _oaFront + numArray;
-
-                // construct outer array
-                _oa.construct(_oaFront);
-
-                // set pointer to beginning of allocated space
-                _dFront = _a.allocate(sizeArray*numArray);
-
-                // allocate inner arrays
-                for (size_type i = 0; i < numArray; ++i) {
-                    _oaFront[i] = &(_dFront[i*sizeArray]);
-                }
-
-                // set pointer to end of the allocated space
-                _dBack = _oaFront[numArray - 1] + sizeArray; 
-
-                // pointer to the end of current array
-                _thisBack = _oaFront[0] + sizeArray;
-
-                // pointers to the beginning and end of data
-                _b = _dFront;
-                _e = _b + s;
-
-                // construct inner arrays
-                if (s <= sizeArray)
-                    uninitialized_fill(_a, _b, _e, v);
-                else {
-                    pointer t_b = _b;
-                    size_type array = 0;
-                    while (_b != _e) {
-                        if (_b == _thisBack) {
-                            ++array;
-                            _b = _oaFront[array];
-                            _thisBack = _oaFront[array] + sizeArray;
-                        } 
-                        else {
-                            _a.construct(&*_b, v);
-                            ++_b;
-                        }
-                    }
-                    _b = t_b;
-                }
-            }
+            if (s == 0)
+                return;
 
-            // size varible
-            dSize = s;
+            // outer array big enough for every inner array, inner arrays as they fill
+            create_map(s / sizeArray + 1);
+            try {
+                while (dSize != s)
+                    push_back(v);}
+            catch (...) {
+                release();
+                throw;}
             assert(valid());
         }
 
@@ -677,63 +1293,61 @@ class MyDeque {
          copy constructor
          */
         MyDeque (const MyDeque& that) :
-                _a(that._a),
-                _oa() {
+                _a(alloc_traits::select_on_container_copy_construction(that._a)),
+                _oa(_a) {
             // <your code>
+            _oaFront = _oaBack = _bArray = _eArray = 0; 
+            _b = _e = 0;
+            _spare = 0;
+            _next = 0;
+            _nextSize = _copied = 0;
+            _nextShift = 0;
+            _incremental = false;
+            dSize = 0;
+            #ifdef DEQUE_DEBUG
+            _gen = 0;
+            #endif
+            #ifdef DEQUE_TRACE
+            _trace = 0;
+            #endif
+
+            // nothing to copy
+            if (that.empty())
+                return;
 
-            // size data
-            numArray = that.numArray;
-            dSize = that.dSize;
-            sizeArray = that.sizeArray;
-
-            // allocate outer array
-            _oaFront = _oa.allocate(numArray); 
-            _oaBack = _oaFront + numArray;
-
-            // construct outer array
-            _oa.construct(_oaFront);
-
-            // pointer to front of allocated space
-            _dFront = _a.allocate(sizeArray*numArray);
-
-            //allocate inner arrays
-            for (size_type i = 0; i < numArray; ++i) {
-                _oaFront[i] = &(_dFront[i*sizeArray]);
-            }       
-
-            // pointers to end of allocated space 
-            _dBack = _oaFront[numArray - 1] + sizeArray;
-
-            _thisBack = _oaFront[0] + sizeArray;
-
-            // data pointers
-            _b = _dFront;
-            _e = _b + dSize;
-
-            // construct inner arrays
-            if(dSize <= sizeArray) 
-                uninitialized_copy(_a, that._b, that._e, _b);
-            else {
-                pointer t_b = _b;
-                size_type array = 0;
-                size_type otherB = 0;
-                while (_b != _e) {
-                    if (_b == _thisBack) {
-                        ++array;
-                        _b = _oaFront[array];
-                        _thisBack = _oaFront[array] + sizeArray;
-                    }
-                    else {
-                        _a.construct(&*_b, *(that._b + otherB));
-                        ++_b;
-                        ++otherB;
-                    }
-                }
-                _b = t_b;
-            }
+            create_map(that.size() / sizeArray + 1);
+            try {
+                for (const_iterator i = that.begin(); i != that.end(); ++i)
+                    push_back(*i);}
+            catch (...) {
+                release();
+                throw;}
             assert(valid());
         }
 
+        /**
+         move constructor, takes over that's storage and leaves it empty
+         */
+        MyDeque (MyDeque&& that) :
+                _a(that._a),
+                _oa(_a) {
+            _oaFront = _oaBack = _bArray = _eArray = 0; 
+            _b = _e = 0;
+            _spare = 0;
+            _next = 0;
+            _nextSize = _copied = 0;
+            _nextShift = 0;
+            _incremental = false;
+            dSize = 0;
+            #ifdef DEQUE_DEBUG
+            _gen = 0;
+            #endif
+            #ifdef DEQUE_TRACE
+            _trace = 0;
+            #endif
+            swap(that);
+        }
+
         // ----------
         // destructor
         // ----------
@@ -744,14 +1358,7 @@ class MyDeque {
          */
         ~MyDeque () {
             // <your code> DONE
-            if(_dFront) {
-                clear();
-                // _dBack = &*destroy(_a, _dFront, _dBack);
-                _a.deallocate(_dFront, _dBack - _dFront);
-            }
-            _oaBack = &*destroy(_oa, _oaFront, _oaBack);
-            _oa.deallocate(_oaFront, _oaBack - _oaFront);
-            assert(valid());
+            release();
         }
 
         // ----------
@@ -761,26 +1368,39 @@ class MyDeque {
         /**
          * <your documentation> DONE
          returns ref to this deque after copying rhs deque to this deque
+         reuses the inner arrays this deque already has
          */
         MyDeque& operator = (const MyDeque& rhs) {
             // <your code> DONE
+            DEQUE_TRACE_OP(TRACE_ASSIGN, rhs.size());
             if(this == &rhs) 
                 return *this;
-            if(rhs.size() == size())
-                copy(rhs.begin(), rhs.end(), begin());
-            else if(rhs.size() < size()) {
+            if(rhs.size() <= size()) {
                 copy(rhs.begin(), rhs.end(), begin());
                 resize(rhs.size());
             }
-            else if(rhs.size() <= (unsigned)(_dBack - _dFront)) {
+            else {
                 copy(rhs.begin(), rhs.begin() + size(), begin());
-                _e = &*uninitialized_copy(_a, rhs.begin() + size(), rhs.end(), end());
+                for (const_iterator i = rhs.begin() + size(); i != rhs.end(); ++i)
+                    push_back(*i);
             }
+            assert(valid());
+            return *this;}
+
+        /**
+         returns ref to this deque after taking over rhs's storage, leaving rhs empty
+         moves the elements over instead if the allocators differ
+         */
+        MyDeque& operator = (MyDeque&& rhs) {
+            DEQUE_TRACE_OP(TRACE_ASSIGN, rhs.size());
+            if (this == &rhs)
+                return *this;
+            if (_a == rhs._a) {
+                clear();
+                swap(rhs);}
             else {
                 clear();
-                MyDeque lhs(rhs);
-                swap(lhs);
-            }
+                move_back(rhs);}
             assert(valid());
             return *this;}
 
@@ -791,12 +1411,15 @@ class MyDeque {
         /**
          * <your documentation> DONE
          returns ref to index-th element
+         the index is offset by the front's place in its inner array, then split
+         into inner array and place with a shift and a mask
          */
         reference operator [] (size_type index) {
             // <your code> DONE
-            // dummy is just to be able to compile the skeleton, remove it
-            // static value_type dummy;
-            return *(_dFront + index);
+            DEQUE_TRACE_OP(TRACE_INDEX, index);
+            assert(index < size());
+            const size_type i = frontOffset() + index;
+            return _bArray[i >> sizeShift][i & (sizeArray - 1)];
         }
 
         /**
@@ -813,11 +1436,13 @@ class MyDeque {
         /**
          * <your documentation> DONE
          returns ref to index-th element
+         throws out_of_range if index isn't less than size()
          */
-        reference at (size_type index) throw (out_of_range) {
+        reference at (size_type index) {
             // <your code> DONE
-            // dummy is just to be able to compile the skeleton, remove it
-            // static value_type dummy;
+            DEQUE_TRACE_OP(TRACE_AT, index);
+            if (index >= size())
+                throw out_of_range("MyDeque::at");
             return (*this)[index];
         }
 
@@ -839,9 +1464,9 @@ class MyDeque {
          */
         reference back () {
             // <your code> DONE
-            // dummy is just to be able to compile the skeleton, remove it
-            // static value_type dummy;
             assert(!empty());
+            if (_e == *_eArray)
+                return _eArray[-1][sizeArray - 1];
             return *(_e - 1);
         }
 
@@ -862,7 +1487,7 @@ class MyDeque {
          */
         iterator begin () {
             // <your code> DONE
-            return iterator(this, 0);
+            return position(0);
         }
 
         /**
@@ -871,7 +1496,7 @@ class MyDeque {
          */
         const_iterator begin () const {
             // <your code> DONE
-            return const_iterator(this, 0);
+            return position(0);
         }
 
         // -----
@@ -881,10 +1506,21 @@ class MyDeque {
         /**
          * <your documentation> DONE
          clears all elements from deque/empties deque 
+         keeps the outer array and the first inner array
          */
         void clear () {
             // <your code> DONE
-            resize(0);
+            DEQUE_TRACE_OP(TRACE_CLEAR, 0);
+            if (!_oaFront)
+                return;
+            settle();
+            destroy(_a, begin(), end());
+            for (oa_pointer p = _bArray + 1; p <= _eArray; ++p) {
+                deallocate_array(*p);
+                *p = 0;}
+            _eArray = _bArray;
+            _e = _b;
+            dSize = 0;
             assert(valid());
         }
 
@@ -910,7 +1546,7 @@ class MyDeque {
          */
         iterator end () {
             // <your code> DONE
-            return iterator(this, size());
+            return position(size());
         }
 
         /**
@@ -919,7 +1555,7 @@ class MyDeque {
          */
         const_iterator end () const {
             // <your code> DONE
-            return const_iterator(this, size());
+            return position(size());
         }
 
         // -----
@@ -932,7 +1568,9 @@ class MyDeque {
          */
         iterator erase (iterator i) {
             // <your code> DONE
+            DEQUE_TRACE_OP(TRACE_ERASE, i - begin());
             assert(!empty());
+            const size_type k = i - begin();
             if(i + 1 == end())
                 pop_back();
             else if (i == begin())
@@ -942,7 +1580,7 @@ class MyDeque {
                 resize(size() - 1);
             }
             assert(valid());
-            return iterator(this, 0);
+            return position(k);
         }
 
         // -----
@@ -955,10 +1593,8 @@ class MyDeque {
          */
         reference front () {
             // <your code> DONE
-            // dummy is just to be able to compile the skeleton, remove it
-            // static value_type dummy;
             assert(!empty());
-            return *_dFront;
+            return *_b;
         }
 
         /**
@@ -978,17 +1614,21 @@ class MyDeque {
          */
         iterator insert (iterator i, const_reference v) {
             // <your code> DONE
+            DEQUE_TRACE_OP(TRACE_INSERT, i - begin());
+            // i doesn't survive a resize that grows the outer array, its index does
+            const size_type k = i - begin();
             if (i == end()) 
                 push_back(v);
             else if (i == begin())
                 push_front(v);
             else {
                 resize(size() + 1);
-                copy(i, end(), i + 1);
+                i = position(k);
+                copy_backward(i, end() - 1, end());
                 *i = v;
             }
             assert(valid());
-            return iterator(this, 0);
+            return position(k);
         }
 
         // ---
@@ -998,23 +1638,68 @@ class MyDeque {
         /**
          * <your documentation> DONE
          removes last element from deque
+         gives back the last inner array when it empties
          */
         void pop_back () {
             // <your code> DONE
+            DEQUE_TRACE_OP(TRACE_POP_BACK, 0);
             assert(!empty());
-            resize(size() - 1);
+            if (_e == *_eArray) {
+                deallocate_array(*_eArray);
+                *_eArray = 0;
+                mirror(_eArray);
+                --_eArray;
+                _e = *_eArray + sizeArray;}
+            --_e;
+            alloc_traits::destroy(_a, _e);
+            --dSize;
+            step();
             assert(valid());
         }
 
         /**
          * <your documentation> DONE
          removes first element from deque
+         gives back the first inner array when it empties
          */
         void pop_front () {
             // <your code> DONE
+            DEQUE_TRACE_OP(TRACE_POP_FRONT, 0);
             assert(!empty());
-            destroy(_a, begin(), begin() + 1);
-            ++_b;
+            alloc_traits::destroy(_a, _b);
+            if (++_b == *_bArray + sizeArray) {
+                deallocate_array(*_bArray);
+                *_bArray = 0;
+                mirror(_bArray);
+                ++_bArray;
+                _b = *_bArray;}
+            --dSize;
+            step();
+            assert(valid());}
+
+        /**
+         removes the first k elements, an inner array at a time
+         destroys each run with one loop and gives back the inner arrays it empties
+         */
+        void pop_front_n (size_type k) {
+            DEQUE_TRACE_OP(TRACE_POP_FRONT_N, k);
+            assert(k <= size());
+            if (k == size()) {
+                clear();
+                return;}
+            settle();
+            while (k != 0) {
+                pointer   end = (_bArray == _eArray) ? _e : *_bArray + sizeArray;
+                size_type n   = std::min(k, size_type(end - _b));
+                destroy(_a, _b, _b + n);
+                _b    += n;
+                dSize -= n;
+                k     -= n;
+                if (_b == *_bArray + sizeArray) {
+                    deallocate_array(*_bArray);
+                    *_bArray = 0;
+                    ++_bArray;
+                    _b = *_bArray;}}
             assert(valid());}
 
         // ----
@@ -1024,70 +1709,383 @@ class MyDeque {
         /**
          * <your documentation> DONE
          adds element of value v to back of deque
+         allocates one inner array when the last one fills, elements never move
          */
         void push_back (const_reference v) {
             // <your code> DONE
-            resize(size() + 1, v);
+            put_back(v);}
+
+        /**
+         adds v to back of deque, moved
+         */
+        void push_back (value_type&& v) {
+            put_back(std::move(v));}
+
+    private:
+        template <typename V>
+        void put_back (V&& v) {
+            DEQUE_TRACE_OP(TRACE_PUSH_BACK, 0);
+            if (!_oaFront)
+                create_map(1);
+            if (_e + 1 != *_eArray + sizeArray)
+                alloc_traits::construct(_a, _e++, std::forward<V>(v));
+            else {
+                reserve_map(false);
+                _eArray[1] = allocate_array();
+                try {
+                    alloc_traits::construct(_a, _e, std::forward<V>(v));}
+                catch (...) {
+                    deallocate_array(_eArray[1]);
+                    _eArray[1] = 0;
+                    throw;}
+                ++_eArray;
+                mirror(_eArray);
+                _e = *_eArray;}
+            ++dSize;
+            step();
             assert(valid());}
 
+    public:
+
         /**
          * <your documentation> DONE
          adds element of value v to front of deque
+         allocates one inner array when the first one is full, elements never move
          */
         void push_front (const_reference v) {
             // <your code>
-            if (_b != _dFront) {
-                _b = &*uninitialized_fill(_a, _b - 1, _b, v);
-                --_b;
-            }
+            put_front(v);}
+
+        /**
+         adds v to front of deque, moved
+         */
+        void push_front (value_type&& v) {
+            put_front(std::move(v));}
+
+    private:
+        template <typename V>
+        void put_front (V&& v) {
+            DEQUE_TRACE_OP(TRACE_PUSH_FRONT, 0);
+            if (!_oaFront)
+                create_map(1);
+            if (_b != *_bArray)
+                alloc_traits::construct(_a, --_b, std::forward<V>(v));
             else {
-                MyDeque x(size() + sizeArray);
-                // NOTE: dFront index is at -sizeArray NOT zero..  
-                uninitialized_copy(x._a, _b, _e, x._b + sizeArray);
-                x._b = x._b + sizeArray;
-                swap(x);
-                push_front(v);
-            }
+                reserve_map(true);
+                _bArray[-1] = allocate_array();
+                try {
+                    alloc_traits::construct(_a, _bArray[-1] + sizeArray - 1, std::forward<V>(v));}
+                catch (...) {
+                    deallocate_array(_bArray[-1]);
+                    _bArray[-1] = 0;
+                    throw;}
+                --_bArray;
+                mirror(_bArray);
+                _b = *_bArray + sizeArray - 1;}
+            ++dSize;
+            step();
             assert(valid());}
 
+    public:
+
         // ------
         // resize
         // ------
 
         /**
          * <your documentation>
+         grows with copies of v at the back, or shrinks from the back, to s elements
          */
         void resize (size_type s, const_reference v = value_type()) {
             // <your code>
-            if (s == size())
-                return;
-            else if (s < size()){
-                _e = &*destroy(_a, _b + s, _e);
-                // size() = _e - _b;
-            }
-            else if (s > size() && s <= (unsigned)(_dBack - _dFront)) {
-                _e = uninitialized_fill(_a, _e, _b + s, v); // space has already been allocated
-            }
-            else {
-                MyDeque x(s, v);
-                uninitialized_copy(x._a, _b, _e, x._b);
-                swap(x);
-                resize(s, v);
-            }
+            DEQUE_TRACE_OP(TRACE_RESIZE, s);
+            while (size() > s)
+                pop_back();
+            while (size() < s)
+                push_back(v);
             assert(valid());
         }
 
-        // ----
-        // size
-        // ----
+        // ------------------
+        // incremental_growth
+        // ------------------
 
         /**
-         * <your documentation> DONE
-         returns number of elements
+         turns incremental growth on or off, it's off to begin with
+         when it's on, the outer array moves to a bigger one (or is recentered) a
+         few slots per push and pop instead of all at once, so no push or pop
+         copies more than a handful of pointers; elements never move either way
          */
-        size_type size () const {
+        void incremental_growth (bool on) {
+            if (!on)
+                settle();
+            _incremental = on;}
+
+        bool incremental_growth () const {
+            return _incremental;}
+
+        // --------
+        // segments
+        // --------
+
+        /**
+         returns the number of contiguous runs the elements are stored in, one per inner array in use
+         */
+        size_type segments () const {
+            if (empty())
+                return 0;
+            return (_eArray - _bArray) + (_e != *_eArray);}
+
+        /**
+         returns the k-th contiguous run of elements as [first, second)
+         */
+        std::pair<pointer, pointer> segment (size_type k) {
+            assert(k < segments());
+            pointer b = (k == 0) ? _b : _bArray[k];
+            pointer e = (_bArray + k == _eArray) ? _e : _bArray[k] + sizeArray;
+            return std::make_pair(b, e);}
+
+        /**
+         returns the k-th contiguous run of elements as [first, second)
+         */
+        std::pair<const_pointer, const_pointer> segment (size_type k) const {
+            std::pair<pointer, pointer> s = const_cast<MyDeque*>(this)->segment(k);
+            return std::make_pair(const_pointer(s.first), const_pointer(s.second));}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         * <your documentation> DONE
+         returns number of elements
+         */
+        size_type size () const {
             // <your code> DONE
-            return _e - _b;}
+            return dSize;}
+
+        // -------------
+        // get_allocator
+        // -------------
+
+        /**
+         * <your documentation> DONE
+         returns a copy of the allocator of the elements
+         */
+        allocator_type get_allocator () const {
+            return _a;}
+
+        // ----
+        // sort
+        // ----
+
+        /**
+         sorts the deque in place, inner arrays in parallel, with a scratch buffer of about size() / 16 elements
+         */
+        void sort () {
+            sort(std::less<value_type>());}
+
+        /**
+         sorts the deque in place by c, inner arrays in parallel, with a scratch buffer of about size() / 16 elements
+         */
+        template <typename C>
+        void sort (C c) {
+            sort(c, 0);}
+
+        /**
+         sorts the deque in place by c, inner arrays split among workers threads
+         workers of 0 means one per core, or just one below 65536 elements
+         */
+        template <typename C>
+        void sort (C c, size_type workers) {
+            DEQUE_TRACE_OP(TRACE_SORT, 0);
+            block_sort(c, false, workers);}
+
+        // ------
+        // splice
+        // ------
+
+        /**
+         moves every element of that to the back of this deque, leaving that empty
+         if this deque's last inner array holds as many elements as that's first one
+         has free places in front, as it does after split_at, that's inner arrays
+         are moved over whole and at most one inner array of elements is moved;
+         otherwise elements can't keep their places in their inner arrays, and the
+         smaller deque's elements are moved across, O(min(size(), that.size())), or
+         if the allocators differ, all of that's
+         */
+        void splice_back (MyDeque&& that) {
+            DEQUE_TRACE_OP(TRACE_SPLICE_BACK, that.size());
+            if ((this == &that) || that.empty())
+                return;
+            settle();
+            that.settle();
+            if (!(_a == that._a)) {
+                move_back(that);
+                return;}
+            if (empty()) {
+                swap(that);
+                return;}
+            const size_type eb = _e - *_eArray;
+            if (eb != that.frontOffset()) {
+                if (that.size() <= size())
+                    move_back(that);
+                else {
+                    that.move_front(*this);
+                    swap(that);}
+                return;}
+            const size_type k = that._eArray - that._bArray;
+            if (eb == 0) {
+                // this deque's last inner array is empty, that's first one takes its slot
+                reserve_map(false, k);
+                deallocate_array(*_eArray);
+                std::copy(that._bArray, that._eArray + 1, _eArray);
+                std::fill(that._bArray, that._eArray + 1, pointer());}
+            else {
+                // fill the rest of this deque's last inner array from that's first one
+                if (k)
+                    reserve_map(false, k);
+                pointer e = (k == 0) ? that._e : *that._bArray + sizeArray;
+                uninitialized_copy(_a, std::make_move_iterator(that._b), std::make_move_iterator(e), _e);
+                destroy(_a, that._b, e);
+                if (k) {
+                    std::copy(that._bArray + 1, that._eArray + 1, _eArray + 1);
+                    std::fill(that._bArray + 1, that._eArray + 1, pointer());}}
+            _eArray += k;
+            _e = (k || (eb == 0)) ? that._e : _e + (that._e - that._b);
+            dSize += that.dSize;
+            that.abandon();
+            #ifdef DEQUE_DEBUG
+            ++_gen;
+            #endif
+            assert(valid());}
+
+        /**
+         moves every element of that to the front of this deque, leaving that empty
+         if that's last inner array holds as many elements as this deque's first one
+         has free places in front, as it does after split_at, that's inner arrays
+         are moved over whole and at most one inner array of elements is moved;
+         otherwise elements can't keep their places in their inner arrays, and the
+         smaller deque's elements are moved across, O(min(size(), that.size())), or
+         if the allocators differ, all of that's
+         */
+        void splice_front (MyDeque&& that) {
+            DEQUE_TRACE_OP(TRACE_SPLICE_FRONT, that.size());
+            if ((this == &that) || that.empty())
+                return;
+            settle();
+            that.settle();
+            if (!(_a == that._a)) {
+                move_front(that);
+                return;}
+            if (empty()) {
+                swap(that);
+                return;}
+            const size_type fo = frontOffset();
+            if (size_type(that._e - *that._eArray) != fo) {
+                if (that.size() <= size())
+                    move_front(that);
+                else {
+                    that.move_back(*this);
+                    swap(that);}
+                return;}
+            // fill the front of this deque's first inner array from that's last one
+            const size_type k = that._eArray - that._bArray;
+            if (k)
+                reserve_map(true, k);
+            pointer b = (k == 0) ? that._b : *that._eArray;
+            uninitialized_copy(_a, std::make_move_iterator(b), std::make_move_iterator(that._e), *_bArray + (b - *that._eArray));
+            destroy(_a, b, that._e);
+            if (k) {
+                std::copy(that._bArray, that._eArray, _bArray - k);
+                std::fill(that._bArray, that._eArray, pointer());}
+            _bArray -= k;
+            _b = (k == 0) ? *_bArray + (that._b - *that._eArray) : that._b;
+            dSize += that.dSize;
+            that.abandon();
+            #ifdef DEQUE_DEBUG
+            ++_gen;
+            #endif
+            assert(valid());}
+
+        // -----
+        // split
+        // -----
+
+        /**
+         returns a deque of the elements from pos on, leaving this deque the ones before
+         the inner arrays after pos's are moved over whole, and only the elements of
+         pos's inner array from pos on are moved
+         */
+        MyDeque split_at (size_type pos) {
+            DEQUE_TRACE_OP(TRACE_SPLIT_AT, pos);
+            assert(pos <= size());
+            settle();
+            MyDeque r(_a);
+            if (pos == size())
+                return r;
+            if (pos == 0) {
+                r.swap(*this);
+                return r;}
+            const size_type o = frontOffset() + pos;
+            oa_pointer      n = _bArray + (o >> sizeShift);
+            pointer         p = *n + (o & (sizeArray - 1));
+            const size_type k = _eArray - n;
+            const bool      whole = (p == *n);
+            r.create_map(k + 1);
+            if (whole) {
+                // pos starts an inner array, this deque gets an empty one in its place
+                pointer fresh = allocate_array();
+                r.deallocate_array(*r._bArray);
+                std::copy(n, _eArray + 1, r._bArray);
+                *n = fresh;
+                r._b = *r._bArray;}
+            else {
+                pointer e = (k == 0) ? _e : *n + sizeArray;
+                r._b = *r._bArray + (p - *n);
+                uninitialized_copy(_a, std::make_move_iterator(p), std::make_move_iterator(e), r._b);
+                destroy(_a, p, e);
+                std::copy(n + 1, _eArray + 1, r._bArray + 1);}
+            std::fill(n + 1, _eArray + 1, pointer());
+            r._eArray = r._bArray + k;
+            r._e      = (k == 0) ? r._b + (_e - p) : _e;
+            r.dSize   = dSize - pos;
+            _eArray = n;
+            _e      = whole ? *n : p;
+            dSize   = pos;
+            #ifdef DEQUE_DEBUG
+            ++_gen;
+            #endif
+            assert(valid());
+            assert(r.valid());
+            return r;}
+
+        // -----------
+        // stable_sort
+        // -----------
+
+        /**
+         sorts the deque in place, keeping the order of equal elements
+         */
+        void stable_sort () {
+            stable_sort(std::less<value_type>());}
+
+        /**
+         sorts the deque in place by c, keeping the order of equal elements
+         */
+        template <typename C>
+        void stable_sort (C c) {
+            stable_sort(c, 0);}
+
+        /**
+         sorts the deque in place by c, keeping the order of equal elements, inner
+         arrays split among workers threads
+         workers of 0 means one per core, or just one below 65536 elements
+         */
+        template <typename C>
+        void stable_sort (C c, size_type workers) {
+            DEQUE_TRACE_OP(TRACE_SORT, 1);
+            block_sort(c, true, workers);}
 
         // ----
         // swap
@@ -1096,25 +2094,749 @@ class MyDeque {
         /**
          * <your documentation> DONE
          swaps elements in this deque with elements in that deque
+         moves them through a third deque if the allocators differ
          */
         void swap (MyDeque& that) {
             // <your code> DONE
             if (_a == that._a) {
+                settle();
+                that.settle();
                 std::swap(_oaFront, that._oaFront);
                 std::swap(_oaBack, that._oaBack);
-                std::swap(_dFront, that._dFront);
-                std::swap(_dBack, that._dBack);
+                std::swap(_bArray, that._bArray);
+                std::swap(_eArray, that._eArray);
                 std::swap(_b, that._b);
                 std::swap(_e, that._e);
+                std::swap(_spare, that._spare);
                 std::swap(dSize, that.dSize);
-                std::swap(numArray, that.numArray);
-                std::swap(sizeArray, that.sizeArray);
+                #ifdef DEQUE_DEBUG
+                ++_gen;
+                ++that._gen;
+                #endif
             }
             else {
-                MyDeque x(*this);
-                *this = that;
-                that = x;
+                MyDeque x(_a);
+                x.move_back(*this);
+                move_back(that);
+                that.move_back(x);
             }
-            assert(valid());}};
+            assert(valid());}
+
+        #ifdef DEQUE_TRACE
+        // -----
+        // trace
+        // -----
+
+        /**
+         records every public operation to t from now on, or stops recording if t is 0
+         */
+        void trace (DequeTraceWriter* t) {
+            _trace = t;}
+        #endif
+        };
+
+template <typename T, typename A>
+const typename MyDeque<T, A>::size_type MyDeque<T, A>::sizeShift;
+
+template <typename T, typename A>
+const typename MyDeque<T, A>::size_type MyDeque<T, A>::sizeArray;
+
+template <typename T, typename A>
+typename MyDeque<T, A>::pointer MyDeque<T, A>::_nullArray = 0;
+
+// --------------
+// MyDeque<bool>
+// --------------
+
+/**
+ a deque of flags, 64 to a word, the words kept in a MyDeque<uint64_t> (so 4096
+ flags to an inner array)
+ flag i is bit (_off + i) % 64 of word (_off + i) / 64; the bits outside the
+ flags in the two edge words are always 0, so count() and find_first() work a
+ word at a time and push_back, push_front, pop_back and pop_front touch only
+ the edge word
+ like vector<bool>, references and iterators are proxies
+ insert, erase, the splices and split_at move flags a bit at a time, O(n) where
+ the primary template moves elements whole or relinks inner arrays; sort just
+ counts, and there's no pop_front_n or segment access
+ */
+template <typename A>
+class MyDeque<bool, A> {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef bool                                                            value_type;
+        typedef typename std::allocator_traits<A>::template rebind_alloc<bool>  allocator_type;
+        typedef std::size_t                                                     size_type;
+        typedef std::ptrdiff_t                                                  difference_type;
+        typedef bool                                                            const_reference;
+
+    private:
+        typedef uint64_t                                                        word;
+        typedef typename std::allocator_traits<A>::template rebind_alloc<word>  word_allocator_type;
+
+        static const size_type wordBits = 64;
+
+    public:
+        // ---------
+        // reference
+        // ---------
+
+        class reference {
+            friend class MyDeque;
+
+            private:
+                word* _w;
+                word  _m;
+
+                reference (word* w, word m) :
+                        _w (w),
+                        _m (m)
+                    {}
+
+            public:
+                operator bool () const {
+                    return (*_w & _m) != 0;}
+
+                reference& operator = (bool v) {
+                    if (v)
+                        *_w |= _m;
+                    else
+                        *_w &= ~_m;
+                    return *this;}
+
+                reference& operator = (const reference& rhs) {
+                    return *this = bool(rhs);}
+
+                void flip () {
+                    *_w ^= _m;}};
+
+        // --------------
+        // const_iterator
+        // --------------
+
+        class const_iterator {
+            friend class MyDeque;
+
+            public:
+                typedef std::random_access_iterator_tag iterator_category;
+                typedef bool                            value_type;
+                typedef std::ptrdiff_t                  difference_type;
+                typedef void                            pointer;
+                typedef bool                            reference;
+
+            private:
+                const MyDeque* _d;
+                size_type      _i;
+
+                const_iterator (const MyDeque* d, size_type i) :
+                        _d (d),
+                        _i (i)
+                    {}
+
+            public:
+                const_iterator () :
+                        _d (0),
+                        _i (0)
+                    {}
+
+                friend bool operator == (const const_iterator& lhs, const const_iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return lhs._i == rhs._i;}
+
+                friend bool operator != (const const_iterator& lhs, const const_iterator& rhs) {
+                    return !(lhs == rhs);}
+
+                friend bool operator < (const const_iterator& lhs, const const_iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return lhs._i < rhs._i;}
+
+                friend const_iterator operator + (const_iterator lhs, difference_type rhs) {
+                    return lhs += rhs;}
+
+                friend const_iterator operator - (const_iterator lhs, difference_type rhs) {
+                    return lhs -= rhs;}
+
+                friend difference_type operator - (const const_iterator& lhs, const const_iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return difference_type(lhs._i) - difference_type(rhs._i);}
+
+                bool operator * () const {
+                    return (*_d)[_i];}
+
+                bool operator [] (difference_type n) const {
+                    return (*_d)[_i + n];}
+
+                const_iterator& operator ++ () {
+                    ++_i;
+                    return *this;}
+
+                const_iterator operator ++ (int) {
+                    const_iterator x = *this;
+                    ++*this;
+                    return x;}
+
+                const_iterator& operator -- () {
+                    --_i;
+                    return *this;}
+
+                const_iterator operator -- (int) {
+                    const_iterator x = *this;
+                    --*this;
+                    return x;}
+
+                const_iterator& operator += (difference_type d) {
+                    _i += d;
+                    return *this;}
+
+                const_iterator& operator -= (difference_type d) {
+                    return *this += -d;}};
+
+        // --------
+        // iterator
+        // --------
+
+        class iterator {
+            friend class MyDeque;
+
+            public:
+                typedef std::random_access_iterator_tag iterator_category;
+                typedef bool                            value_type;
+                typedef std::ptrdiff_t                  difference_type;
+                typedef void                            pointer;
+                typedef typename MyDeque::reference     reference;
+
+            private:
+                MyDeque*  _d;
+                size_type _i;
+
+                iterator (MyDeque* d, size_type i) :
+                        _d (d),
+                        _i (i)
+                    {}
+
+            public:
+                iterator () :
+                        _d (0),
+                        _i (0)
+                    {}
+
+                operator const_iterator () const {
+                    return const_iterator(_d, _i);}
+
+                friend bool operator == (const iterator& lhs, const iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return lhs._i == rhs._i;}
+
+                friend bool operator != (const iterator& lhs, const iterator& rhs) {
+                    return !(lhs == rhs);}
+
+                friend bool operator < (const iterator& lhs, const iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return lhs._i < rhs._i;}
+
+                friend iterator operator + (iterator lhs, difference_type rhs) {
+                    return lhs += rhs;}
+
+                friend iterator operator - (iterator lhs, difference_type rhs) {
+                    return lhs -= rhs;}
+
+                friend difference_type operator - (const iterator& lhs, const iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return difference_type(lhs._i) - difference_type(rhs._i);}
+
+                reference operator * () const {
+                    return (*_d)[_i];}
+
+                reference operator [] (difference_type n) const {
+                    return (*_d)[_i + n];}
+
+                iterator& operator ++ () {
+                    ++_i;
+                    return *this;}
+
+                iterator operator ++ (int) {
+                    iterator x = *this;
+                    ++*this;
+                    return x;}
+
+                iterator& operator -- () {
+                    --_i;
+                    return *this;}
+
+                iterator operator -- (int) {
+                    iterator x = *this;
+                    --*this;
+                    return x;}
+
+                iterator& operator += (difference_type d) {
+                    _i += d;
+                    return *this;}
+
+                iterator& operator -= (difference_type d) {
+                    return *this += -d;}};
+
+    public:
+        // -----------
+        // operator ==
+        // -----------
+
+        friend bool operator == (const MyDeque& lhs, const MyDeque& rhs) {
+            return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());}
+
+        // ----------
+        // operator <
+        // ----------
+
+        friend bool operator < (const MyDeque& lhs, const MyDeque& rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());}
+
+    private:
+        // ----
+        // data
+        // ----
+
+        MyDeque<word, word_allocator_type> _w;    // the words, bits outside the flags are 0
+        size_type                          _off;  // bit of the first flag in _w.front()
+        size_type                          dSize; // number of flags
+
+        bool valid () const {
+            return (_off < wordBits) &&
+                   (_w.size() == (dSize ? (_off + dSize + wordBits - 1) / wordBits : 0)) &&
+                   (dSize || !_off);}
+
+        // returns the mask of bits [b, e) of a word, 0 <= b < e <= 64
+        static word bits (size_type b, size_type e) {
+            const word hi = (e == wordBits) ? ~word(0) : (word(1) << e) - 1;
+            return hi & ~((word(1) << b) - 1);}
+
+        /**
+         calls f(w, m, i) on each word of flags until f returns true: m masks the
+         bits that are flags, w is the word masked by m, i is the index of the
+         flag in bit 0
+         */
+        template <typename F>
+        void for_words (F f) const {
+            if (empty())
+                return;
+            const size_type last = _w.size() - 1;
+            const size_type stop = (_off + dSize - 1) % wordBits + 1;
+            size_type k = 0;
+            for (size_type s = 0; s != _w.segments(); ++s) {
+                std::pair<const word*, const word*> r = _w.segment(s);
+                for (const word* p = r.first; p != r.second; ++p, ++k) {
+                    word m = ~word(0);
+                    if (k == 0)
+                        m &= bits(_off, wordBits);
+                    if (k == last)
+                        m &= bits(0, stop);
+                    if (f(*p & m, m, k * wordBits - _off))
+                        return;}}}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        explicit MyDeque (const allocator_type& a = allocator_type()) :
+                _w (word_allocator_type(a)),
+                _off (0),
+                dSize (0)
+            {}
+
+        explicit MyDeque (size_type s, bool v = false, const allocator_type& a = allocator_type()) :
+                _w (word_allocator_type(a)),
+                _off (0),
+                dSize (0) {
+            resize(s, v);}
+
+        MyDeque (const MyDeque& that) :
+                _w (that._w),
+                _off (that._off),
+                dSize (that.dSize)
+            {}
+
+        /**
+         takes over that's words and leaves it empty
+         */
+        MyDeque (MyDeque&& that) :
+                _w (that._w.get_allocator()),
+                _off (0),
+                dSize (0) {
+            swap(that);}
+
+        // ----------
+        // operator =
+        // ----------
+
+        MyDeque& operator = (const MyDeque& rhs) {
+            _w    = rhs._w;
+            _off  = rhs._off;
+            dSize = rhs.dSize;
+            return *this;}
+
+        /**
+         takes over rhs's words and leaves it empty
+         */
+        MyDeque& operator = (MyDeque&& rhs) {
+            if (this == &rhs)
+                return *this;
+            clear();
+            swap(rhs);
+            assert(valid() && rhs.valid());
+            return *this;}
+
+        // -----------
+        // operator []
+        // -----------
+
+        reference operator [] (size_type index) {
+            assert(index < size());
+            const size_type p = _off + index;
+            return reference(&_w[p / wordBits], word(1) << (p % wordBits));}
+
+        const_reference operator [] (size_type index) const {
+            assert(index < size());
+            const size_type p = _off + index;
+            return (_w[p / wordBits] >> (p % wordBits)) & 1;}
+
+        // --
+        // at
+        // --
+
+        reference at (size_type index) {
+            if (index >= size())
+                throw std::out_of_range("MyDeque::at index out of range");
+            return (*this)[index];}
+
+        const_reference at (size_type index) const {
+            if (index >= size())
+                throw std::out_of_range("MyDeque::at index out of range");
+            return (*this)[index];}
+
+        // ----
+        // back
+        // ----
+
+        reference back () {
+            assert(!empty());
+            return (*this)[size() - 1];}
+
+        const_reference back () const {
+            assert(!empty());
+            return (*this)[size() - 1];}
+
+        // -----
+        // begin
+        // -----
+
+        iterator begin () {
+            return iterator(this, 0);}
+
+        const_iterator begin () const {
+            return const_iterator(this, 0);}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            _w.clear();
+            _off  = 0;
+            dSize = 0;}
+
+        // -----
+        // erase
+        // -----
+
+        /**
+         removes the flag at i, shifting the flags on the nearer side of it over
+         by one, a flag at a time
+         */
+        iterator erase (iterator i) {
+            assert((i._d == this) && (i._i < size()));
+            const size_type k = i._i;
+            if (k < size() - k - 1) {
+                for (size_type j = k; j != 0; --j)
+                    (*this)[j] = bool((*this)[j - 1]);
+                pop_front();}
+            else {
+                for (size_type j = k; j + 1 != size(); ++j)
+                    (*this)[j] = bool((*this)[j + 1]);
+                pop_back();}
+            return iterator(this, k);}
+
+        // -----
+        // count
+        // -----
+
+        /**
+         returns the number of flags equal to v, a popcount per word
+         */
+        size_type count (bool v = true) const {
+            size_type n = 0;
+            for_words([&n] (word w, word, size_type) {
+                n += std::popcount(w);
+                return false;});
+            return v ? n : size() - n;}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return !size();}
+
+        // ---
+        // end
+        // ---
+
+        iterator end () {
+            return iterator(this, size());}
+
+        const_iterator end () const {
+            return const_iterator(this, size());}
+
+        // ----------
+        // find_first
+        // ----------
+
+        /**
+         returns the index of the first flag equal to v, or size() if there isn't one
+         skips whole words of the other value
+         */
+        size_type find_first (bool v = true) const {
+            size_type r = size();
+            for_words([&r, v] (word w, word m, size_type i) {
+                if (!v)
+                    w = ~w & m;
+                if (!w)
+                    return false;
+                r = i + std::countr_zero(w);
+                return true;});
+            return r;}
+
+        // -----
+        // front
+        // -----
+
+        reference front () {
+            assert(!empty());
+            return (*this)[0];}
+
+        const_reference front () const {
+            assert(!empty());
+            return (*this)[0];}
+
+        // ------------------
+        // incremental_growth
+        // ------------------
+
+        /**
+         grows the outer array of the words incrementally, see MyDeque::incremental_growth
+         */
+        void incremental_growth (bool on) {
+            _w.incremental_growth(on);}
+
+        bool incremental_growth () const {
+            return _w.incremental_growth();}
+
+        // ------
+        // insert
+        // ------
+
+        /**
+         inserts v before i, shifting the flags on the nearer side of it over by
+         one, a flag at a time
+         */
+        iterator insert (iterator i, bool v) {
+            assert((i._d == this) && (i._i <= size()));
+            const size_type k = i._i;
+            if (k < size() - k) {
+                push_front(false);
+                for (size_type j = 0; j != k; ++j)
+                    (*this)[j] = bool((*this)[j + 1]);}
+            else {
+                push_back(false);
+                for (size_type j = size() - 1; j != k; --j)
+                    (*this)[j] = bool((*this)[j - 1]);}
+            (*this)[k] = v;
+            return iterator(this, k);}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            assert(!empty());
+            (*this)[size() - 1] = false;
+            if (--dSize == 0)
+                clear();
+            else if ((_off + dSize) % wordBits == 0)
+                _w.pop_back();
+            assert(valid());}
+
+        void pop_front () {
+            assert(!empty());
+            (*this)[0] = false;
+            --dSize;
+            if (dSize == 0)
+                clear();
+            else if (++_off == wordBits) {
+                _w.pop_front();
+                _off = 0;}
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        void push_back (bool v) {
+            if ((_off + dSize) % wordBits == 0)
+                _w.push_back(0);
+            ++dSize;
+            if (v)
+                (*this)[dSize - 1] = true;
+            assert(valid());}
+
+        void push_front (bool v) {
+            if (empty()) {
+                push_back(v);
+                return;}
+            if (_off == 0) {
+                _w.push_front(0);
+                _off = wordBits;}
+            --_off;
+            ++dSize;
+            if (v)
+                (*this)[0] = true;
+            assert(valid());}
+
+        // ------
+        // resize
+        // ------
+
+        /**
+         grows or shrinks at the back, whole words at a time
+         */
+        void resize (size_type s, bool v = false) {
+            if (s == 0) {
+                clear();
+                return;}
+            if (s < size()) {
+                _w.resize((_off + s + wordBits - 1) / wordBits);
+                const size_type stop = (_off + s) % wordBits;
+                if (stop)
+                    _w.back() &= bits(0, stop);
+                dSize = s;}
+            else {
+                while ((size() < s) && ((_off + dSize) % wordBits != 0))
+                    push_back(v);
+                const size_type k = (s - size()) / wordBits;
+                _w.resize(_w.size() + k, v ? ~word(0) : word(0));
+                dSize += k * wordBits;
+                while (size() < s)
+                    push_back(v);}
+            assert(valid());}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return dSize;}
+
+        // ----
+        // sort
+        // ----
+
+        /**
+         equal flags can't be told apart, so sorting just counts the trues and
+         rewrites the flags, whole words at a time
+         */
+        void sort () {
+            sort(std::less<bool>());}
+
+        template <typename C>
+        void sort (C c) {
+            const bool first = c(true, false);   // the value that sorts first
+            if (!first && !c(false, true))
+                return;
+            const size_type n = size();
+            const size_type k = count(first);
+            clear();
+            resize(k, first);
+            resize(n, !first);}
+
+        void stable_sort () {
+            sort();}
+
+        template <typename C>
+        void stable_sort (C c) {
+            sort(c);}
+
+        // ------
+        // splice
+        // ------
+
+        /**
+         moves every flag of that to the back of this deque, leaving that empty,
+         a flag at a time
+         */
+        void splice_back (MyDeque&& that) {
+            if (this == &that)
+                return;
+            for (size_type i = 0; i != that.size(); ++i)
+                push_back(bool(that[i]));
+            that.clear();}
+
+        /**
+         moves every flag of that to the front of this deque, leaving that empty,
+         a flag at a time
+         */
+        void splice_front (MyDeque&& that) {
+            if (this == &that)
+                return;
+            for (size_type i = that.size(); i != 0; --i)
+                push_front(bool(that[i - 1]));
+            that.clear();}
+
+        /**
+         returns a deque of the flags from pos on, leaving this deque the ones before
+         */
+        MyDeque split_at (size_type pos) {
+            assert(pos <= size());
+            MyDeque r(get_allocator());
+            for (size_type i = pos; i != size(); ++i)
+                r.push_back(bool((*this)[i]));
+            resize(pos);
+            return r;}
+
+        /**
+         returns the bytes the flags take, 8 per 64 of them
+         */
+        size_type bytes () const {
+            return _w.size() * sizeof(word);}
+
+        // -------------
+        // get_allocator
+        // -------------
+
+        allocator_type get_allocator () const {
+            return allocator_type(_w.get_allocator());}
+
+        // ----
+        // swap
+        // ----
+
+        void swap (MyDeque& that) {
+            _w.swap(that._w);
+            std::swap(_off, that._off);
+            std::swap(dSize, that.dSize);}};
+
+template <typename A>
+const typename MyDeque<bool, A>::size_type MyDeque<bool, A>::wordBits;
 
 #endif // Deque_h
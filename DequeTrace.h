@@ -0,0 +1,210 @@
+// ---------------------------
+// projects/deque/DequeTrace.h
+// ---------------------------
+
+#ifndef DequeTrace_h
+#define DequeTrace_h
+
+// --------
+// includes
+// --------
+
+#include <cstddef> // size_t
+#include <cstdio>  // FILE, fopen, fread, fwrite, fclose
+#include <cstring> // memcmp
+
+// ------------
+// DequeTraceOp
+// ------------
+
+/**
+ op codes of the public MyDeque operations a trace records
+ not traced: swap, writes through iterators and references, incremental_growth,
+ and what splice_back and splice_front take out of the other deque
+ */
+enum DequeTraceOp {
+    TRACE_PUSH_BACK    = 0,
+    TRACE_PUSH_FRONT   = 1,
+    TRACE_POP_BACK     = 2,
+    TRACE_POP_FRONT    = 3,
+    TRACE_INDEX        = 4,
+    TRACE_AT           = 5,
+    TRACE_INSERT       = 6,
+    TRACE_ERASE        = 7,
+    TRACE_RESIZE       = 8,
+    TRACE_CLEAR        = 9,
+    TRACE_ASSIGN       = 10,
+    TRACE_POP_FRONT_N  = 11,
+    TRACE_SORT         = 12,
+    TRACE_SPLICE_BACK  = 13,
+    TRACE_SPLICE_FRONT = 14,
+    TRACE_SPLIT_AT     = 15,
+    TRACE_OPS          = 16};
+
+// ----------------
+// DequeTraceRecord
+// ----------------
+
+/**
+ one recorded operation: op code, index (new size for resize and assign, count for
+ pop_front_n and the splices, 1 for a stable sort) and the size before the operation
+ */
+struct DequeTraceRecord {
+    unsigned char op;
+    size_t        index;
+    size_t        size;};
+
+// ----------------
+// DequeTraceWriter
+// ----------------
+
+/**
+ appends records to a binary trace file
+ a record is the op code byte followed by index and size as LEB128 varints,
+ so most records take 3 to 5 bytes; they're buffered and written 64 KB at a time
+ */
+class DequeTraceWriter {
+    private:
+        FILE*         _f;
+        unsigned char _buf[1 << 16];
+        size_t        _n;
+
+        void flush () {
+            if (_f && _n)
+                std::fwrite(_buf, 1, _n, _f);
+            _n = 0;}
+
+        void varint (size_t v) {
+            while (v >= 0x80) {
+                _buf[_n++] = static_cast<unsigned char>(v | 0x80);
+                v >>= 7;}
+            _buf[_n++] = static_cast<unsigned char>(v);}
+
+        DequeTraceWriter (const DequeTraceWriter&);
+        DequeTraceWriter& operator = (const DequeTraceWriter&);
+
+    public:
+        /**
+         opens (truncates) the trace file at path
+         */
+        explicit DequeTraceWriter (const char* path) :
+                _f (std::fopen(path, "wb")),
+                _n (0) {
+            if (_f)
+                std::fwrite("DQTR\1", 1, 5, _f);}
+
+        ~DequeTraceWriter () {
+            flush();
+            if (_f)
+                std::fclose(_f);}
+
+        /**
+         bool returns true if the file opened
+         */
+        bool good () const {
+            return _f != 0;}
+
+        /**
+         appends one record
+         */
+        void record (unsigned char op, size_t index, size_t size) {
+            if (_n > sizeof(_buf) - 32)
+                flush();
+            _buf[_n++] = op;
+            varint(index);
+            varint(size);}};
+
+// ----------------
+// DequeTraceReader
+// ----------------
+
+/**
+ reads back the records of a trace file written by DequeTraceWriter
+ */
+class DequeTraceReader {
+    private:
+        FILE* _f;
+
+        bool varint (size_t& v) {
+            v = 0;
+            for (int s = 0; s < 64; s += 7) {
+                const int c = std::fgetc(_f);
+                if (c == EOF)
+                    return false;
+                v |= static_cast<size_t>(c & 0x7F) << s;
+                if (!(c & 0x80))
+                    return true;}
+            return false;}
+
+        DequeTraceReader (const DequeTraceReader&);
+        DequeTraceReader& operator = (const DequeTraceReader&);
+
+    public:
+        /**
+         opens the trace file at path, good() is false if it isn't a trace
+         */
+        explicit DequeTraceReader (const char* path) :
+                _f (std::fopen(path, "rb")) {
+            char magic[5];
+            if (_f && ((std::fread(magic, 1, 5, _f) != 5) || std::memcmp(magic, "DQTR\1", 5))) {
+                std::fclose(_f);
+                _f = 0;}}
+
+        ~DequeTraceReader () {
+            if (_f)
+                std::fclose(_f);}
+
+        bool good () const {
+            return _f != 0;}
+
+        /**
+         bool returns false at the end of the trace, otherwise reads the next record into r
+         */
+        bool next (DequeTraceRecord& r) {
+            if (!_f)
+                return false;
+            const int c = std::fgetc(_f);
+            if ((c == EOF) || (c >= TRACE_OPS))
+                return false;
+            r.op = static_cast<unsigned char>(c);
+            return varint(r.index) && varint(r.size);}};
+
+// --------------
+// DEQUE_TRACE_OP
+// --------------
+
+/**
+ records op at the top of a traced MyDeque member and mutes the trace for the
+ public members it calls in turn, so each public call is one record
+ compiles to nothing unless DEQUE_TRACE is defined
+ */
+#ifdef DEQUE_TRACE
+
+class DequeTraceScope {
+    private:
+        DequeTraceWriter*& _t;
+        DequeTraceWriter*  _saved;
+
+        DequeTraceScope (const DequeTraceScope&);
+        DequeTraceScope& operator = (const DequeTraceScope&);
+
+    public:
+        DequeTraceScope (DequeTraceWriter*& t, unsigned char op, size_t index, size_t size) :
+                _t (t),
+                _saved (t) {
+            if (_t) {
+                _t->record(op, index, size);
+                _t = 0;}}
+
+        ~DequeTraceScope () {
+            _t = _saved;}};
+
+#define DEQUE_TRACE_OP(op, index) DequeTraceScope _traceScope(_trace, (op), (index), size())
+
+#else
+
+#define DEQUE_TRACE_OP(op, index)
+
+#endif // DEQUE_TRACE
+
+#endif // DequeTrace_h
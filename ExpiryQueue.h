@@ -0,0 +1,199 @@
+// ----------------------------
+// projects/deque/ExpiryQueue.h
+// ----------------------------
+
+#ifndef ExpiryQueue_h
+#define ExpiryQueue_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>   // upper_bound
+#include <cassert>     // assert
+#include <cstddef>     // size_t
+#include <memory>      // allocator
+#include <type_traits> // decay
+#include <utility>     // declval, pair
+
+#include "Deque.h"
+
+// -----------
+// ExpiryFirst
+// -----------
+
+/**
+ the default key of an ExpiryQueue element: its first member, as in
+ std::pair<timestamp, value>
+ */
+struct ExpiryFirst {
+    template <typename T>
+    const typename T::first_type& operator () (const T& v) const {
+        return v.first;}};
+
+// -----------
+// ExpiryQueue
+// -----------
+
+/**
+ a TTL queue: elements are pushed at the back with keys (timestamps, say) that
+ never decrease, and expire from the front
+ since the deque is sorted by key, expire_until finds its cutoff with a
+ galloping binary search over operator [] and removes everything in front of
+ it with MyDeque::pop_front_n, one destroy loop and one deallocation per inner
+ array, instead of a front() check and a pop_front() per element; a sweep that
+ expires just the front is a plain pop_front()
+ */
+template <typename T, typename KeyOf = ExpiryFirst, typename A = std::allocator<T> >
+class ExpiryQueue {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T                                                                               value_type;
+        typedef typename std::decay<decltype(std::declval<KeyOf>()(std::declval<const T&>()))>::type key_type;
+        typedef typename MyDeque<T, A>::size_type                                               size_type;
+        typedef typename MyDeque<T, A>::const_iterator                                          const_iterator;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        MyDeque<T, A>   _d;
+        KeyOf           _k;
+
+        // ------
+        // cutoff
+        // ------
+
+        /**
+         returns the number of elements whose key is at most t
+         gallops from the front (1, 2, 4, ... elements) before the binary search,
+         so it's O(log k) in the number expiring, not in the size of the queue
+         */
+        size_type cutoff (const key_type& t) const {
+            const size_type n = _d.size();
+            if ((n == 0) || (t < _k(_d[0])))
+                return 0;
+            size_type lo = 0;    // key of _d[lo] is at most t
+            size_type hi = 1;
+            while ((hi < n) && !(t < _k(_d[hi]))) {
+                lo = hi;
+                hi = (hi <= n / 2) ? 2 * hi : n;}
+            const KeyOf& k = _k;
+            return std::upper_bound(_d.begin() + (lo + 1), _d.begin() + hi, t,
+                                    [&k] (const key_type& x, const T& v) {return x < k(v);}) - _d.begin();}
+
+        /**
+         returns how many of the first two elements have a key of at most t
+         most sweeps of a steady queue expire none or one, and those skip the
+         search and the bulk pop
+         */
+        size_type head (const key_type& t) const {
+            if (_d.empty() || (t < _k(_d.front())))
+                return 0;
+            return ((_d.size() == 1) || (t < _k(_d[1]))) ? 1 : 2;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        explicit ExpiryQueue (const KeyOf& k = KeyOf(), const A& a = A()) :
+                _d (a),
+                _k (k)
+            {}
+
+        // ----
+        // push
+        // ----
+
+        /**
+         appends v, whose key must be at least the key of back()
+         */
+        void push (const T& v) {
+            assert(_d.empty() || !(_k(v) < _k(_d.back())));
+            _d.push_back(v);}
+
+        // ------------
+        // expire_until
+        // ------------
+
+        /**
+         removes every element whose key is at most t
+         returns the number removed
+         */
+        size_type expire_until (const key_type& t) {
+            const size_type h = head(t);
+            if (h < 2) {
+                if (h)
+                    _d.pop_front();
+                return h;}
+            const size_type n = cutoff(t);
+            _d.pop_front_n(n);
+            return n;}
+
+        /**
+         removes every element whose key is at most t, first handing them to
+         f(const T* b, const T* e) as contiguous runs, oldest first
+         returns the number removed
+         */
+        template <typename F>
+        size_type expire_until (const key_type& t, F f) {
+            const size_type h = head(t);
+            if (h < 2) {
+                if (h) {
+                    f(&_d.front(), &_d.front() + 1);
+                    _d.pop_front();}
+                return h;}
+            const size_type n = cutoff(t);
+            size_type       m = 0;
+            for (size_type s = 0; m != n; ++s) {
+                std::pair<const T*, const T*> r = static_cast<const MyDeque<T, A>&>(_d).segment(s);
+                if (size_type(r.second - r.first) > n - m)
+                    r.second = r.first + (n - m);
+                f(r.first, r.second);
+                m += r.second - r.first;}
+            _d.pop_front_n(n);
+            return n;}
+
+        /**
+         returns the number of elements whose key is at most t, without removing them
+         */
+        size_type expiring (const key_type& t) const {
+            return cutoff(t);}
+
+        // -----
+        // front
+        // -----
+
+        const T& front () const {
+            assert(!empty());
+            return _d.front();}
+
+        const T& back () const {
+            assert(!empty());
+            return _d.back();}
+
+        const_iterator begin () const {
+            return _d.begin();}
+
+        const_iterator end () const {
+            return _d.end();}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _d.size();}
+
+        bool empty () const {
+            return _d.empty();}
+
+        void clear () {
+            _d.clear();}};
+
+#endif // ExpiryQueue_h
@@ -0,0 +1,277 @@
+// ----------------------------
+// projects/deque/HandleDeque.h
+// ----------------------------
+
+#ifndef HandleDeque_h
+#define HandleDeque_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>   // assert
+#include <cstddef>   // size_t
+#include <memory>    // allocator, allocator_traits
+#include <optional>  // optional
+#include <stdint.h>  // uint32_t, uint64_t
+
+#include "Deque.h"
+
+// -----------
+// DequeHandle
+// -----------
+
+/**
+ names one element pushed into a HandleDeque, for as long as it's there
+ one word: the element's absolute sequence number in the low 40 bits and the
+ stamp of its push in the high 24; the default handle names nothing
+ */
+class DequeHandle {
+    template <typename, typename>
+    friend class HandleDeque;
+
+    private:
+        uint64_t _v;
+
+        static const int      seqBits = 40;
+        static const uint64_t seqMask = (uint64_t(1) << seqBits) - 1;
+
+        DequeHandle (uint64_t seq, uint32_t stamp) :
+                _v ((uint64_t(stamp) << seqBits) | (seq & seqMask))
+            {}
+
+        uint64_t seq () const {
+            return _v & seqMask;}
+
+        uint32_t stamp () const {
+            return static_cast<uint32_t>(_v >> seqBits);}
+
+    public:
+        DequeHandle () :
+                _v (0)
+            {}
+
+        /**
+         returns the handle as one word, to store or send elsewhere
+         */
+        uint64_t value () const {
+            return _v;}
+
+        static DequeHandle from_value (uint64_t v) {
+            DequeHandle h;
+            h._v = v;
+            return h;}
+
+        friend bool operator == (const DequeHandle& lhs, const DequeHandle& rhs) {
+            return lhs._v == rhs._v;}};
+
+// -----------
+// HandleDeque
+// -----------
+
+/**
+ a MyDeque whose pushes return a DequeHandle, for callers that keep references
+ to queued elements (cancellation of pending jobs, say)
+ get(handle) is O(1) and gives 0 once the element is gone, whatever was popped
+ in front of it; cancel(handle) is amortized O(1) and leaves a tombstone that
+ pops skip (a cancel or pop at an end sweeps the tombstones behind it)
+ a handle is the element's position counted from a fixed origin, modulo 2^40,
+ so pops at the front don't move it, plus a 24-bit stamp from a counter of pushes that
+ the slot keeps too; a position reused by pop_back or clear gets a new stamp,
+ so a stale handle can only come back to life after 2^24 more pushes
+ */
+template <typename T, typename A = std::allocator<T> >
+class HandleDeque {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T                                                                   value_type;
+        typedef DequeHandle                                                         handle;
+
+    private:
+        struct Slot {
+            std::optional<T> v;       // empty in a tombstone
+            uint32_t         stamp;};
+
+        typedef typename std::allocator_traits<A>::template rebind_alloc<Slot>      slot_allocator_type;
+
+    public:
+        typedef typename MyDeque<Slot, slot_allocator_type>::size_type              size_type;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        MyDeque<Slot, slot_allocator_type>  _d;       // tombstones never at either end
+        uint64_t                            _front;   // sequence number of _d.front(), modulo 2^40
+        uint32_t                            _stamp;   // stamp of the last push
+        size_type                           _dead;    // tombstones in _d
+
+        static const uint64_t origin = uint64_t(1) << 39; // first sequence number, room both ways
+
+        bool valid () const {
+            return (_dead < _d.size() || (_dead == 0)) &&
+                   (_d.empty() || (_d.front().v && _d.back().v));}
+
+        uint32_t next_stamp () {
+            _stamp = (_stamp + 1) & ((uint32_t(1) << 24) - 1);
+            if (_stamp == 0)
+                _stamp = 1;
+            return _stamp;}
+
+        // trims tombstones off both ends, so front() and back() are live
+        void trim () {
+            while (!_d.empty() && !_d.front().v) {
+                _d.pop_front();
+                _front = (_front + 1) & handle::seqMask;
+                --_dead;}
+            while (!_d.empty() && !_d.back().v) {
+                _d.pop_back();
+                --_dead;}}
+
+        Slot* find (handle h) {
+            const uint64_t k = (h.seq() - _front) & handle::seqMask;  // h's distance from the front
+            if (k >= _d.size())
+                return 0;
+            Slot& x = _d[k];
+            return (x.v && (x.stamp == h.stamp())) ? &x : 0;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         first is the sequence number of the first push_back, origin unless a
+         test wants to start near the wrap at 2^40
+         */
+        explicit HandleDeque (const A& a = A(), uint64_t first = origin) :
+                _d (slot_allocator_type(a)),
+                _front (first & handle::seqMask),
+                _stamp (0),
+                _dead (0)
+            {}
+
+        // ---
+        // get
+        // ---
+
+        /**
+         returns the element h names, or 0 if it was popped or cancelled
+         */
+        T* get (handle h) {
+            Slot* x = find(h);
+            return x ? &*x->v : 0;}
+
+        const T* get (handle h) const {
+            return const_cast<HandleDeque*>(this)->get(h);}
+
+        // ------
+        // cancel
+        // ------
+
+        /**
+         destroys the element h names and leaves a tombstone in its place
+         returns false if it was already popped or cancelled
+         */
+        bool cancel (handle h) {
+            Slot* x = find(h);
+            if (!x)
+                return false;
+            x->v.reset();
+            ++_dead;
+            trim();
+            assert(valid());
+            return true;}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            _d.clear();
+            _front = origin;
+            _dead  = 0;}
+
+        // -----
+        // front
+        // -----
+
+        T& front () {
+            assert(!empty());
+            return *_d.front().v;}
+
+        T& back () {
+            assert(!empty());
+            return *_d.back().v;}
+
+        // ---
+        // pop
+        // ---
+
+        /**
+         removes the first live element and the tombstones behind it
+         */
+        void pop_front () {
+            assert(!empty());
+            _d.pop_front();
+            _front = (_front + 1) & handle::seqMask;
+            trim();
+            assert(valid());}
+
+        /**
+         removes the last live element and the tombstones in front of it
+         */
+        void pop_back () {
+            assert(!empty());
+            _d.pop_back();
+            trim();
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        /**
+         appends v, returns its handle
+         */
+        handle push_back (const T& v) {
+            const Slot x = {v, next_stamp()};
+            _d.push_back(x);
+            return handle(_front + _d.size() - 1, x.stamp);}
+
+        /**
+         prepends v, returns its handle
+         */
+        handle push_front (const T& v) {
+            const Slot x = {v, next_stamp()};
+            _d.push_front(x);
+            _front = (_front - 1) & handle::seqMask;
+            return handle(_front, x.stamp);}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         returns the number of live elements
+         */
+        size_type size () const {
+            return _d.size() - _dead;}
+
+        bool empty () const {
+            return size() == 0;}
+
+        /**
+         returns the number of slots, live elements and tombstones
+         */
+        size_type slots () const {
+            return _d.size();}};
+
+template <typename T, typename A>
+const uint64_t HandleDeque<T, A>::origin;
+
+#endif // HandleDeque_h
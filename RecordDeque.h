@@ -0,0 +1,331 @@
+// ----------------------------
+// projects/deque/RecordDeque.h
+// ----------------------------
+
+#ifndef RecordDeque_h
+#define RecordDeque_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>   // assert
+#include <cstddef>   // size_t
+#include <cstring>   // memcpy
+#include <memory>    // allocator, allocator_traits
+#include <span>      // span
+#include <stdint.h>  // uint32_t
+#include <string>    // string
+
+#include "Deque.h"
+
+// ----------
+// RecordView
+// ----------
+
+/**
+ a read-only view of one record's bytes, valid until the record is popped
+ */
+class RecordView {
+    private:
+        const char* _p;
+        std::size_t _n;
+
+    public:
+        RecordView () :
+                _p (0),
+                _n (0)
+            {}
+
+        RecordView (const void* p, std::size_t n) :
+                _p (static_cast<const char*>(p)),
+                _n (n)
+            {}
+
+        RecordView (const std::string& s) :
+                _p (s.data()),
+                _n (s.size())
+            {}
+
+        const char* data () const {
+            return _p;}
+
+        std::size_t size () const {
+            return _n;}
+
+        bool empty () const {
+            return _n == 0;}
+
+        const char* begin () const {
+            return _p;}
+
+        const char* end () const {
+            return _p + _n;}
+
+        std::string str () const {
+            return std::string(_p, _n);}};
+
+inline bool operator == (const RecordView& lhs, const RecordView& rhs) {
+    return (lhs.size() == rhs.size()) && (std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);}
+
+inline bool operator != (const RecordView& lhs, const RecordView& rhs) {
+    return !(lhs == rhs);}
+
+// -----------
+// RecordDeque
+// -----------
+
+/**
+ a FIFO of variable-length byte records packed into large blocks
+ each record is a 4 byte length followed by its bytes; a record that doesn't fit
+ in what's left of the back block starts a new one, so every record is
+ contiguous and the tail of a block is the only padding
+ the blocks sit in a MyDeque, so there's no allocation per record; one emptied
+ block is kept to absorb the next one a steady stream needs
+ */
+template <typename A = std::allocator<char> >
+class RecordDeque {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef A                                               allocator_type;
+        typedef std::allocator_traits<A>                        alloc_traits;
+        typedef std::size_t                                     size_type;
+
+        static const size_type header = sizeof(uint32_t);       // bytes of the length prefix
+
+    private:
+        // -----
+        // Block
+        // -----
+
+        struct Block {
+            char*     data;
+            size_type capacity;
+            size_type used;};   // bytes written, records end here
+
+        typedef typename alloc_traits::template rebind_alloc<Block> block_allocator_type;
+
+        // ----
+        // data
+        // ----
+
+        allocator_type                          _a;
+        MyDeque<Block, block_allocator_type>    _blocks;
+        Block                                   _spare;     // an emptied block, or data 0
+        size_type                               _read;      // offset of the first record in the front block
+        size_type                               _size;      // records
+        size_type                               _bytes;     // record bytes, without headers
+        size_type                               _blockSize;
+
+        RecordDeque (const RecordDeque&);
+        RecordDeque& operator = (const RecordDeque&);
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            if (_blocks.empty())
+                return !_size && !_bytes && !_read;
+            return (_read <= _blocks.front().used) &&
+                   ((_size == 0) == ((_blocks.size() == 1) && (_read == _blocks.front().used)));}
+
+        // -----
+        // block
+        // -----
+
+        /**
+         returns a block of at least n bytes, the spare one if it's big enough
+         */
+        Block block (size_type n) {
+            Block b;
+            if (_spare.data && (_spare.capacity >= n)) {
+                b = _spare;
+                _spare.data = 0;}
+            else {
+                b.capacity = (n > _blockSize) ? n : _blockSize;
+                b.data     = alloc_traits::allocate(_a, b.capacity);}
+            b.used = 0;
+            return b;}
+
+        /**
+         keeps b as the spare block, giving back the smaller of b and the old spare
+         */
+        void recycle (Block b) {
+            if (_spare.data && (_spare.capacity >= b.capacity)) {
+                alloc_traits::deallocate(_a, b.data, b.capacity);
+                return;}
+            if (_spare.data)
+                alloc_traits::deallocate(_a, _spare.data, _spare.capacity);
+            _spare = b;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         constructs an empty record deque that packs records into blocks of blockSize bytes
+         records longer than a block get a block of their own
+         */
+        explicit RecordDeque (size_type blockSize = 65536, const allocator_type& a = allocator_type()) :
+                _a (a),
+                _blocks (block_allocator_type(_a)),
+                _read (0),
+                _size (0),
+                _bytes (0),
+                _blockSize (blockSize) {
+            _spare.data = 0;
+            assert(valid());}
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~RecordDeque () {
+            clear();
+            if (!_blocks.empty()) {
+                recycle(_blocks.back());
+                _blocks.pop_back();}
+            if (_spare.data)
+                alloc_traits::deallocate(_a, _spare.data, _spare.capacity);}
+
+        // -----
+        // clear
+        // -----
+
+        /**
+         removes every record, keeping one block for reuse
+         */
+        void clear () {
+            while (_blocks.size() > 1) {
+                recycle(_blocks.front());
+                _blocks.pop_front();}
+            if (!_blocks.empty())
+                _blocks.front().used = 0;
+            _read  = 0;
+            _size  = 0;
+            _bytes = 0;
+            assert(valid());}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return _size == 0;}
+
+        // -----
+        // front
+        // -----
+
+        /**
+         returns a view of the first record
+         */
+        RecordView front () const {
+            assert(!empty());
+            const Block& b = _blocks.front();
+            uint32_t n;
+            std::memcpy(&n, b.data + _read, header);
+            return RecordView(b.data + _read + header, n);}
+
+        // ---------
+        // pop_front
+        // ---------
+
+        /**
+         removes the first record, giving its block up for reuse once it's drained
+         */
+        void pop_front () {
+            assert(!empty());
+            Block& b = _blocks.front();
+            uint32_t n;
+            std::memcpy(&n, b.data + _read, header);
+            _read  += header + n;
+            _bytes -= n;
+            --_size;
+            if (_read == b.used) {
+                if (_blocks.size() > 1) {
+                    recycle(b);
+                    _blocks.pop_front();}
+                else
+                    b.used = 0;
+                _read = 0;}
+            assert(valid());}
+
+        // ---------
+        // push_back
+        // ---------
+
+        /**
+         appends a copy of the n bytes at p as one record
+         */
+        void push_back (const void* p, size_type n) {
+            assert(n <= uint32_t(-1));
+            const size_type need = header + n;
+            if (empty() && !_blocks.empty() && (_blocks.back().capacity < need)) {
+                recycle(_blocks.back());
+                _blocks.pop_back();}
+            if (_blocks.empty() || (_blocks.back().capacity - _blocks.back().used < need)) {
+                Block b = block(need);
+                try {
+                    _blocks.push_back(b);}
+                catch (...) {
+                    recycle(b);
+                    throw;}}
+            Block& b = _blocks.back();
+            const uint32_t len = static_cast<uint32_t>(n);
+            std::memcpy(b.data + b.used, &len, header);
+            std::memcpy(b.data + b.used + header, p, n);
+            b.used += need;
+            _bytes += n;
+            ++_size;
+            assert(valid());}
+
+        /**
+         appends a copy of the bytes r views as one record
+         */
+        void push_back (const RecordView& r) {
+            push_back(r.data(), r.size());}
+
+        /**
+         appends a copy of the bytes s spans as one record
+         */
+        void push_back (std::span<const char> s) {
+            push_back(s.data(), s.size());}
+
+        /**
+         appends a copy of s's bytes as one record
+         */
+        void push_back (const std::string& s) {
+            push_back(s.data(), s.size());}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         returns the number of records
+         */
+        size_type size () const {
+            return _size;}
+
+        /**
+         returns the number of record bytes, without length prefixes
+         */
+        size_type bytes () const {
+            return _bytes;}
+
+        /**
+         returns the number of blocks in use
+         */
+        size_type blocks () const {
+            return _blocks.size();}};
+
+template <typename A>
+const typename RecordDeque<A>::size_type RecordDeque<A>::header;
+
+#endif // RecordDeque_h
@@ -0,0 +1,209 @@
+// ------------------------------
+// projects/deque/ReplayDeque.c++
+// ------------------------------
+
+/*
+ * ReplayDeque
+ *
+ * To compile this, use the command
+ * g++ -pedantic -std=c++20 -Wall -O2 -DNDEBUG ReplayDeque.c++ -o ReplayDeque
+ *
+ * Then it can run with
+ * ReplayDeque trace
+ *
+ * where trace was recorded by a program built with -DDEQUE_TRACE that called
+ * MyDeque::trace(&writer) on the deque of interest. The trace is replayed
+ * against MyDeque<int> and std::deque<int>, timing every operation.
+ */
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // sort, stable_sort
+#include <chrono>    // steady_clock
+#include <deque>     // deque
+#include <iomanip>   // setw
+#include <iostream>  // cout
+#include <utility>   // move
+#include <stdint.h>  // uint32_t
+#include <vector>    // vector
+
+#include "Deque.h"
+
+// -----
+// names
+// -----
+
+const char* const names[TRACE_OPS] = {
+    "push_back", "push_front", "pop_back", "pop_front", "operator[]",
+    "at", "insert", "erase", "resize", "clear", "operator=", "pop_front_n",
+    "sort", "splice_back", "splice_front", "split_at"};
+
+// ----------
+// operations
+// ----------
+
+// the MyDeque operations std::deque doesn't have, with std::deque doing the
+// same thing its own way
+
+template <typename C>
+void pop_front_n (C& c, size_t k) {
+    c.erase(c.begin(), c.begin() + k);}
+
+template <typename T>
+void pop_front_n (MyDeque<T>& c, size_t k) {
+    c.pop_front_n(k);}
+
+template <typename C>
+void sort (C& c, bool stable) {
+    if (stable)
+        std::stable_sort(c.begin(), c.end());
+    else
+        std::sort(c.begin(), c.end());}
+
+template <typename T>
+void sort (MyDeque<T>& c, bool stable) {
+    if (stable)
+        c.stable_sort();
+    else
+        c.sort();}
+
+template <typename C>
+void splice_back (C& c, C& x) {
+    c.insert(c.end(), x.begin(), x.end());}
+
+template <typename T>
+void splice_back (MyDeque<T>& c, MyDeque<T>& x) {
+    c.splice_back(std::move(x));}
+
+template <typename C>
+void splice_front (C& c, C& x) {
+    c.insert(c.begin(), x.begin(), x.end());}
+
+template <typename T>
+void splice_front (MyDeque<T>& c, MyDeque<T>& x) {
+    c.splice_front(std::move(x));}
+
+template <typename C>
+void split_at (C& c, size_t pos, C& x) {
+    x.assign(c.begin() + pos, c.end());
+    c.erase(c.begin() + pos, c.end());}
+
+template <typename T>
+void split_at (MyDeque<T>& c, size_t pos, MyDeque<T>& x) {
+    x = c.split_at(pos);}
+
+// -------
+// Latency
+// -------
+
+/**
+ nanoseconds of every replayed operation, by op code
+ */
+struct Latency {
+    std::vector<uint32_t> ns[TRACE_OPS];
+    size_t                skipped;
+    size_t                diverged;
+
+    Latency () :
+            skipped (0),
+            diverged (0)
+        {}};
+
+// ------
+// replay
+// ------
+
+/**
+ replays trace against an empty C, skipping operations the container can't
+ take (pops when empty, indices out of range) and counting size mismatches
+ */
+template <typename C>
+void replay (const std::vector<DequeTraceRecord>& trace, Latency& l) {
+    typedef std::chrono::steady_clock clock;
+    C        c;
+    long     sink = 0;
+    for (size_t i = 0; i != trace.size(); ++i) {
+        const DequeTraceRecord& r = trace[i];
+        const int v = static_cast<int>(i);
+        if (c.size() != r.size)
+            ++l.diverged;
+        if ((((r.op == TRACE_POP_BACK) || (r.op == TRACE_POP_FRONT)) && c.empty()) ||
+            (((r.op == TRACE_INDEX) || (r.op == TRACE_AT) || (r.op == TRACE_ERASE)) && (r.index >= c.size())) ||
+            (((r.op == TRACE_INSERT) || (r.op == TRACE_POP_FRONT_N) || (r.op == TRACE_SPLIT_AT)) && (r.index > c.size()))) {
+            ++l.skipped;
+            continue;}
+        C x;
+        if ((r.op == TRACE_ASSIGN) || (r.op == TRACE_SPLICE_BACK) || (r.op == TRACE_SPLICE_FRONT))
+            x.resize(r.index);
+        clock::time_point b = clock::now();
+        switch (r.op) {
+            case TRACE_PUSH_BACK:    c.push_back(v);                    break;
+            case TRACE_PUSH_FRONT:   c.push_front(v);                   break;
+            case TRACE_POP_BACK:     c.pop_back();                      break;
+            case TRACE_POP_FRONT:    c.pop_front();                     break;
+            case TRACE_INDEX:        sink += c[r.index];                break;
+            case TRACE_AT:           sink += c.at(r.index);             break;
+            case TRACE_INSERT:       c.insert(c.begin() + r.index, v);  break;
+            case TRACE_ERASE:        c.erase(c.begin() + r.index);      break;
+            case TRACE_RESIZE:       c.resize(r.index);                 break;
+            case TRACE_CLEAR:        c.clear();                         break;
+            case TRACE_ASSIGN:       c = x;                             break;
+            case TRACE_POP_FRONT_N:  pop_front_n(c, r.index);           break;
+            case TRACE_SORT:         sort(c, r.index != 0);             break;
+            case TRACE_SPLICE_BACK:  splice_back(c, x);                 break;
+            case TRACE_SPLICE_FRONT: splice_front(c, x);                break;
+            case TRACE_SPLIT_AT:     split_at(c, r.index, x);           break;}
+        clock::time_point e = clock::now();
+        l.ns[r.op].push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(e - b).count()));}
+    if (sink == 42)
+        std::cout << "";}
+
+// ------
+// report
+// ------
+
+uint32_t percentile (const std::vector<uint32_t>& v, double q) {
+    return v[std::min(v.size() - 1, static_cast<size_t>(q * v.size()))];}
+
+void report (const char* name, Latency& l) {
+    std::cout << name << " (" << l.skipped << " skipped, " << l.diverged << " size mismatches)" << std::endl;
+    std::cout << "  " << std::setw(12) << "op" << std::setw(12) << "count"
+              << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(10) << "p999 ns" << std::endl;
+    for (int op = 0; op != TRACE_OPS; ++op) {
+        std::vector<uint32_t>& v = l.ns[op];
+        if (v.empty())
+            continue;
+        std::sort(v.begin(), v.end());
+        std::cout << "  " << std::setw(12) << names[op] << std::setw(12) << v.size()
+                  << std::setw(10) << percentile(v, 0.5)
+                  << std::setw(10) << percentile(v, 0.99)
+                  << std::setw(10) << percentile(v, 0.999) << std::endl;}}
+
+// ----
+// main
+// ----
+
+int main (int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "usage: ReplayDeque trace" << std::endl;
+        return 1;}
+    DequeTraceReader in(argv[1]);
+    if (!in.good()) {
+        std::cerr << argv[1] << ": not a deque trace" << std::endl;
+        return 1;}
+    std::vector<DequeTraceRecord> trace;
+    DequeTraceRecord r;
+    while (in.next(r))
+        trace.push_back(r);
+    std::cout << trace.size() << " operations" << std::endl;
+
+    Latency my;
+    replay< MyDeque<int> >(trace, my);
+    report("MyDeque", my);
+
+    Latency std_;
+    replay< std::deque<int> >(trace, std_);
+    report("std::deque", std_);
+    return 0;}
@@ -0,0 +1,275 @@
+// -----------------------------
+// projects/deque/ShardedQueue.h
+// -----------------------------
+
+#ifndef ShardedQueue_h
+#define ShardedQueue_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // max, min
+#include <atomic>    // atomic
+#include <cassert>   // assert
+#include <cstddef>   // size_t
+#include <memory>    // allocator, allocator_traits
+#include <mutex>     // mutex, lock_guard
+#include <new>       // placement new
+#include <stdint.h>  // uint64_t
+#include <thread>    // thread
+#include <utility>   // move
+
+#include "Deque.h"
+
+// ------------
+// ShardedQueue
+// ------------
+
+/**
+ a multi-producer, multi-consumer queue made of shards, each a MyDeque behind
+ its own lock on its own cache line, instead of one MyDeque behind one lock
+ threads go through a Local, one per thread, which has a home shard (handed out
+ round robin): pushes are buffered in the Local and appended to the home shard
+ batchSize at a time, under one lock; pops are served from a batch taken off the
+ front of the home shard, and when that's empty, stolen from the fuller of two
+ other shards picked at random (power of two choices), up to half of it
+ ordering is relaxed: each shard is FIFO, and so is what one Local pushes, but
+ there's no order across shards, and a pushed element isn't visible to other
+ threads until its batch is flushed
+ */
+template <typename T, typename A = std::allocator<T> >
+class ShardedQueue {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T                                                   value_type;
+        typedef typename MyDeque<T, A>::size_type                   size_type;
+
+        static const size_type batchSize = 32;                      // elements per flush or take
+
+    private:
+        // -----
+        // Shard
+        // -----
+
+        struct alignas(64) Shard {
+            std::mutex              m;
+            MyDeque<T, A>           d;
+            std::atomic<size_type>  n;          // d.size(), read without the lock to pick a victim
+
+            explicit Shard (const A& a) :
+                    d (a),
+                    n (0)
+                {}};
+
+        typedef typename std::allocator_traits<A>::template rebind_alloc<Shard> shard_allocator_type;
+        typedef std::allocator_traits<shard_allocator_type>                     shard_traits;
+
+        // ----
+        // data
+        // ----
+
+        A                       _a;
+        shard_allocator_type    _sa;
+        Shard*                  _shards;
+        size_type               _n;
+        std::atomic<size_type>  _next;          // the home of the next Local
+
+        ShardedQueue (const ShardedQueue&);
+        ShardedQueue& operator = (const ShardedQueue&);
+
+    public:
+        // -----
+        // Local
+        // -----
+
+        /**
+         a thread's way into the queue, with its home shard and its batches
+         */
+        class Local {
+            private:
+                ShardedQueue&   _q;
+                size_type       _home;
+                uint64_t        _x;             // xorshift state for picking victims
+                MyDeque<T, A>   _out;           // pushed, not yet flushed
+                MyDeque<T, A>   _in;            // taken from a shard, not yet popped
+
+                Local (const Local&);
+                Local& operator = (const Local&);
+
+                size_type random () {
+                    _x ^= _x << 13;
+                    _x ^= _x >> 7;
+                    _x ^= _x << 17;
+                    return size_type(_x % _q._n);}
+
+                /**
+                 moves up to k elements off the front of s into _in
+                 a batch is smaller than an inner array, so moving its elements one by
+                 one beats split_at, which would move the block pointers of the rest
+                 returns the number moved
+                 */
+                size_type take (Shard& s, size_type k) {
+                    std::lock_guard<std::mutex> l(s.m);
+                    k = std::min(k, s.d.size());
+                    for (size_type i = 0; i != k; ++i) {
+                        _in.push_back(std::move(s.d.front()));
+                        s.d.pop_front();}
+                    s.n.store(s.d.size(), std::memory_order_relaxed);
+                    return k;}
+
+                /**
+                 takes from the fuller of two other shards picked at random, up to
+                 half of it, and failing that from the first other shard that has any
+                 */
+                bool steal () {
+                    const size_type q = _q._n;
+                    if (q == 1)
+                        return false;
+                    for (int t = 0; t != 2; ++t) {
+                        size_type i = random();
+                        size_type j = random();
+                        if (i == _home)
+                            i = (i + 1) % q;
+                        if (j == _home)
+                            j = (j + q - 1) % q;
+                        Shard&          s = (_q._shards[i].n.load(std::memory_order_relaxed) >=
+                                             _q._shards[j].n.load(std::memory_order_relaxed)) ? _q._shards[i] : _q._shards[j];
+                        const size_type n = s.n.load(std::memory_order_relaxed);
+                        if (n && take(s, std::min(batchSize, (n + 1) / 2)))
+                            return true;}
+                    for (size_type i = (_home + 1) % q; i != _home; i = (i + 1) % q)
+                        if (take(_q._shards[i], batchSize))
+                            return true;
+                    return false;}
+
+            public:
+                explicit Local (ShardedQueue& q) :
+                        _q    (q),
+                        _home (q._next.fetch_add(1) % q._n),
+                        _x    (0x9E3779B97F4A7C15ULL * (_home + 1)),
+                        _out  (q._a),
+                        _in   (q._a)
+                    {}
+
+                /**
+                 flushes what's pushed and gives back what's taken, to the front of
+                 the home shard
+                 */
+                ~Local () {
+                    flush();
+                    if (_in.empty())
+                        return;
+                    Shard& s = _q._shards[_home];
+                    std::lock_guard<std::mutex> l(s.m);
+                    s.d.splice_front(std::move(_in));
+                    s.n.store(s.d.size(), std::memory_order_relaxed);}
+
+                // ----
+                // push
+                // ----
+
+                /**
+                 buffers v, flushing once batchSize are buffered
+                 */
+                void push (const T& v) {
+                    _out.push_back(v);
+                    if (_out.size() == batchSize)
+                        flush();}
+
+                void push (T&& v) {
+                    _out.push_back(std::move(v));
+                    if (_out.size() == batchSize)
+                        flush();}
+
+                /**
+                 appends the buffered elements to the home shard
+                 */
+                void flush () {
+                    if (_out.empty())
+                        return;
+                    Shard& s = _q._shards[_home];
+                    std::lock_guard<std::mutex> l(s.m);
+                    s.d.splice_back(std::move(_out));
+                    s.n.store(s.d.size(), std::memory_order_relaxed);}
+
+                // ---
+                // pop
+                // ---
+
+                /**
+                 pops an element into v: from the batch taken last, else a batch off
+                 the home shard, else this Local's own unflushed pushes, else a batch
+                 stolen from another shard
+                 returns false if there was none anywhere
+                 */
+                bool pop (T& v) {
+                    if (_in.empty() && !take(_q._shards[_home], batchSize)) {
+                        if (!_out.empty()) {
+                            v = std::move(_out.front());
+                            _out.pop_front();
+                            return true;}
+                        if (!steal())
+                            return false;}
+                    v = std::move(_in.front());
+                    _in.pop_front();
+                    return true;}
+
+                size_type home () const {
+                    return _home;}};
+
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         shards of 0 means one per hardware thread
+         */
+        explicit ShardedQueue (size_type shards = 0, const A& a = A()) :
+                _a    (a),
+                _sa   (a),
+                _n    (shards ? shards : std::max(size_type(std::thread::hardware_concurrency()), size_type(1))),
+                _next (0) {
+            _shards = shard_traits::allocate(_sa, _n);
+            for (size_type i = 0; i != _n; ++i)
+                new (_shards + i) Shard(_a);}
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         no Local may be left
+         */
+        ~ShardedQueue () {
+            for (size_type i = 0; i != _n; ++i)
+                _shards[i].~Shard();
+            shard_traits::deallocate(_sa, _shards, _n);}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         returns the number of elements in the shards, not counting what Locals
+         have buffered; exact only while no thread is pushing or popping
+         */
+        size_type size () const {
+            size_type s = 0;
+            for (size_type i = 0; i != _n; ++i)
+                s += _shards[i].n.load(std::memory_order_relaxed);
+            return s;}
+
+        bool empty () const {
+            return size() == 0;}
+
+        size_type shards () const {
+            return _n;}};
+
+template <typename T, typename A>
+const typename ShardedQueue<T, A>::size_type ShardedQueue<T, A>::batchSize;
+
+#endif // ShardedQueue_h
@@ -0,0 +1,394 @@
+// -------------------------
+// projects/deque/SoADeque.h
+// -------------------------
+
+#ifndef SoADeque_h
+#define SoADeque_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>     // assert
+#include <cstddef>     // ptrdiff_t, size_t
+#include <iterator>    // random_access_iterator_tag
+#include <tuple>       // get, tuple, tuple_element
+#include <type_traits> // integral_constant
+#include <utility>     // pair
+
+#include "Deque.h"
+
+// -----------
+// SoAIndices
+// -----------
+
+/**
+ the indices 0 .. N-1 as a parameter pack, for expanding over a tuple's elements
+ */
+template <std::size_t... Is>
+struct SoAIndices {};
+
+template <std::size_t N, std::size_t... Is>
+struct SoAMakeIndices : SoAMakeIndices<N - 1, N - 1, Is...> {};
+
+template <std::size_t... Is>
+struct SoAMakeIndices<0, Is...> {
+    typedef SoAIndices<Is...> type;};
+
+// --------
+// SoADeque
+// --------
+
+/**
+ a deque of records with the fields Fields..., one MyDeque per field
+ every column grows and shrinks in lockstep, so a record's fields sit at the same
+ inner array and place in every column, and a scan of one field touches only
+ that field's inner arrays
+ */
+template <typename... Fields>
+class SoADeque {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef std::tuple<Fields...>           value_type;
+        typedef std::tuple<Fields&...>          reference;
+        typedef std::tuple<const Fields&...>    const_reference;
+        typedef std::size_t                     size_type;
+        typedef std::ptrdiff_t                  difference_type;
+
+        static const size_type columns = sizeof...(Fields);
+
+        template <std::size_t I>
+        struct column_type {
+            typedef typename std::tuple_element<I, value_type>::type type;};
+
+    private:
+        typedef typename SoAMakeIndices<sizeof...(Fields)>::type indices;
+
+        template <std::size_t I>
+        struct at_ :
+            std::integral_constant<std::size_t, I> {};
+
+        // ----
+        // data
+        // ----
+
+        std::tuple<MyDeque<Fields>...> _c;
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return valid(at_<1>());}
+
+        template <std::size_t I>
+        bool valid (at_<I>) const {
+            return (std::get<I>(_c).size() == size()) && valid(at_<I + 1>());}
+
+        bool valid (at_<sizeof...(Fields)>) const {
+            return true;}
+
+        // -------
+        // helpers
+        // -------
+
+        template <std::size_t... Is>
+        reference get (size_type i, SoAIndices<Is...>) {
+            return reference(std::get<Is>(_c)[i]...);}
+
+        template <std::size_t I>
+        void push_back (const value_type& v, at_<I>) {
+            std::get<I>(_c).push_back(std::get<I>(v));
+            try {
+                push_back(v, at_<I + 1>());}
+            catch (...) {
+                std::get<I>(_c).pop_back();
+                throw;}}
+
+        void push_back (const value_type&, at_<sizeof...(Fields)>)
+            {}
+
+        template <std::size_t I>
+        void push_front (const value_type& v, at_<I>) {
+            std::get<I>(_c).push_front(std::get<I>(v));
+            try {
+                push_front(v, at_<I + 1>());}
+            catch (...) {
+                std::get<I>(_c).pop_front();
+                throw;}}
+
+        void push_front (const value_type&, at_<sizeof...(Fields)>)
+            {}
+
+        template <typename F, std::size_t I>
+        void each (F f, at_<I>) {
+            f(std::get<I>(_c));
+            each(f, at_<I + 1>());}
+
+        template <typename F>
+        void each (F, at_<sizeof...(Fields)>)
+            {}
+
+        struct pop_back_f {
+            template <typename C>
+            void operator () (C& c) const {
+                c.pop_back();}};
+
+        struct pop_front_f {
+            template <typename C>
+            void operator () (C& c) const {
+                c.pop_front();}};
+
+        struct clear_f {
+            template <typename C>
+            void operator () (C& c) const {
+                c.clear();}};
+
+        template <std::size_t I>
+        void swap (SoADeque& that, at_<I>) {
+            std::get<I>(_c).swap(std::get<I>(that._c));
+            swap(that, at_<I + 1>());}
+
+        void swap (SoADeque&, at_<sizeof...(Fields)>)
+            {}
+
+    public:
+        // --------
+        // iterator
+        // --------
+
+        /**
+         random access by record index; dereferencing gives a tuple of references
+         to the record's fields, a proxy like vector<bool>'s
+         */
+        class iterator {
+            friend class SoADeque;
+
+            public:
+                // --------
+                // typedefs
+                // --------
+
+                typedef std::random_access_iterator_tag    iterator_category;
+                typedef typename SoADeque::value_type      value_type;
+                typedef typename SoADeque::difference_type difference_type;
+                typedef void                               pointer;
+                typedef typename SoADeque::reference       reference;
+
+            private:
+                SoADeque* _d;
+                size_type _i;
+
+                iterator (SoADeque* d, size_type i) :
+                        _d (d),
+                        _i (i)
+                    {}
+
+            public:
+                iterator () :
+                        _d (0),
+                        _i (0)
+                    {}
+
+                reference operator * () const {
+                    return (*_d)[_i];}
+
+                reference operator [] (difference_type d) const {
+                    return (*_d)[_i + d];}
+
+                iterator& operator ++ () {
+                    ++_i;
+                    return *this;}
+
+                iterator operator ++ (int) {
+                    iterator x = *this;
+                    ++*this;
+                    return x;}
+
+                iterator& operator -- () {
+                    --_i;
+                    return *this;}
+
+                iterator operator -- (int) {
+                    iterator x = *this;
+                    --*this;
+                    return x;}
+
+                iterator& operator += (difference_type d) {
+                    _i += d;
+                    return *this;}
+
+                iterator& operator -= (difference_type d) {
+                    _i -= d;
+                    return *this;}
+
+                friend iterator operator + (iterator lhs, difference_type d) {
+                    return lhs += d;}
+
+                friend iterator operator - (iterator lhs, difference_type d) {
+                    return lhs -= d;}
+
+                friend difference_type operator - (const iterator& lhs, const iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return difference_type(lhs._i) - difference_type(rhs._i);}
+
+                friend bool operator == (const iterator& lhs, const iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return lhs._i == rhs._i;}
+
+                friend bool operator != (const iterator& lhs, const iterator& rhs) {
+                    return !(lhs == rhs);}
+
+                friend bool operator < (const iterator& lhs, const iterator& rhs) {
+                    assert(lhs._d == rhs._d);
+                    return lhs._i < rhs._i;}};
+
+        // ------------
+        // constructors
+        // ------------
+
+        SoADeque ()
+            {}
+
+        // -----------
+        // operator []
+        // -----------
+
+        /**
+         returns references to the index-th record's fields
+         */
+        reference operator [] (size_type index) {
+            assert(index < size());
+            return get(index, indices());}
+
+        /**
+         returns const references to the index-th record's fields
+         */
+        const_reference operator [] (size_type index) const {
+            return const_reference(const_cast<SoADeque*>(this)->operator[](index));}
+
+        // -----
+        // begin
+        // -----
+
+        iterator begin () {
+            return iterator(this, 0);}
+
+        iterator end () {
+            return iterator(this, size());}
+
+        // ------
+        // column
+        // ------
+
+        /**
+         returns the deque of field I
+         */
+        template <std::size_t I>
+        const MyDeque<typename column_type<I>::type>& column () const {
+            return std::get<I>(_c);}
+
+        /**
+         returns the k-th contiguous run of field I as [first, second)
+         segment k covers the same records in every column
+         */
+        template <std::size_t I>
+        std::pair<typename column_type<I>::type*, typename column_type<I>::type*> segment (size_type k) {
+            return std::get<I>(_c).segment(k);}
+
+        template <std::size_t I>
+        std::pair<const typename column_type<I>::type*, const typename column_type<I>::type*> segment (size_type k) const {
+            return std::get<I>(_c).segment(k);}
+
+        /**
+         returns the number of contiguous runs each column is stored in
+         */
+        size_type segments () const {
+            return std::get<0>(_c).segments();}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            each(clear_f(), at_<0>());
+            assert(valid());}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return size() == 0;}
+
+        // -----
+        // front
+        // -----
+
+        reference front () {
+            assert(!empty());
+            return (*this)[0];}
+
+        reference back () {
+            assert(!empty());
+            return (*this)[size() - 1];}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            assert(!empty());
+            each(pop_back_f(), at_<0>());
+            assert(valid());}
+
+        void pop_front () {
+            assert(!empty());
+            each(pop_front_f(), at_<0>());
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        /**
+         appends the record v, leaving every column as it was if a field's copy throws
+         */
+        void push_back (const value_type& v) {
+            push_back(v, at_<0>());
+            assert(valid());}
+
+        void push_back (const Fields&... fields) {
+            push_back(value_type(fields...));}
+
+        /**
+         prepends the record v, leaving every column as it was if a field's copy throws
+         */
+        void push_front (const value_type& v) {
+            push_front(v, at_<0>());
+            assert(valid());}
+
+        void push_front (const Fields&... fields) {
+            push_front(value_type(fields...));}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return std::get<0>(_c).size();}
+
+        // ----
+        // swap
+        // ----
+
+        void swap (SoADeque& that) {
+            swap(that, at_<0>());}};
+
+template <typename... Fields>
+const typename SoADeque<Fields...>::size_type SoADeque<Fields...>::columns;
+
+#endif // SoADeque_h
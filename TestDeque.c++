@@ -8,7 +8,7 @@
  * TestDeque
  *
  * To compile this, use the command
- * g++ -pedantic -std=c++0x -Wall TestDeque.c++ -o TestDeque -lgtest -lgtest_main -lpthread
+ * g++ -pedantic -std=c++20 -Wall TestDeque.c++ -o TestDeque -lgtest -lgtest_main -lpthread
  *
  * Then it can run with
  * TestDeque
@@ -26,6 +26,8 @@
 #include <sstream>   // ostringstream
 #include <stdexcept> // invalid_argument
 #include <string>    // ==
+#include <thread>    // thread
+#include <vector>    // vector
 
 #include "gtest/gtest.h"                        // Google Test framework
 
@@ -33,9 +35,21 @@
 #include <iterator>
 #include <memory>
 #include <utility>
+#include <cstdio>
 #include <cstdlib>
 
+#include "AppendLog.h"
+#include "AsyncDeque.h"
+#include "BlockAllocator.h"
+#include "Channel.h"
+#include "CompressedDeque.h"
 #include "Deque.h"
+#include "ExpiryQueue.h"
+#include "HandleDeque.h"
+#include "RecordDeque.h"
+#include "ShardedQueue.h"
+#include "SoADeque.h"
+#include "Window.h"
 // includes from Deque.h
 
 #define class struct
@@ -242,15 +256,15 @@ TEST (PushFront, push_front_2) {
     MyDeque<int> x(1, 1000);
     x.push_front(1);
     ASSERT_TRUE(x.size() == 2);
-    ASSERT_TRUE(x[9] == 1);
-    ASSERT_TRUE(x[10] == 1000);
+    ASSERT_TRUE(x[0] == 1);
+    ASSERT_TRUE(x[1] == 1000);
 }
 
 TEST (PushFront, push_front_3) {
     MyDeque<int> x(10, 1000);
     x.push_front(1);
     ASSERT_TRUE(x.size() == 11);
-    ASSERT_TRUE(x[9] == 1);
+    ASSERT_TRUE(x[0] == 1);
     ASSERT_TRUE(x[10] == 1000);
 }
 
@@ -315,7 +329,7 @@ TEST (PopBack, pop_back_1) {
     MyDeque<int> x(5);
     x.pop_back();
     ASSERT_TRUE(x.size() == 4);
-    ASSERT_TRUE(x[4] == 0);
+    ASSERT_TRUE(x[3] == 0);
 }
 
 TEST (PopBack, pop_back_2) {
@@ -328,7 +342,7 @@ TEST (PopBack, pop_back_3) {
     MyDeque<int> x(11, 100);
     x.pop_back();
     ASSERT_TRUE(x.size() == 10);
-    ASSERT_TRUE(x[10] == 100);
+    ASSERT_TRUE(x[9] == 100);
 }
 
 
@@ -475,9 +489,24 @@ TEST (At, at_3) {
     x.push_back(1);
     x.push_back(2);
     x.push_front(3);
-    ASSERT_TRUE(x.at(10) == 1);
-    ASSERT_TRUE(x.at(11) == 2);
-    ASSERT_TRUE(x.at(9) == 3);
+    ASSERT_TRUE(x.at(1) == 1);
+    ASSERT_TRUE(x.at(2) == 2);
+    ASSERT_TRUE(x.at(0) == 3);
+}
+
+TEST (At, at_4) {
+    MyDeque<int> x(3, 1);
+    x.pop_front();
+    ASSERT_TRUE(x.at(1) == 1);
+    try {
+        x.at(2);
+        ASSERT_TRUE(false);}
+    catch (const std::out_of_range&) {}
+    const MyDeque<int>& y = x;
+    try {
+        y.at(1000);
+        ASSERT_TRUE(false);}
+    catch (const std::out_of_range&) {}
 }
 
 
@@ -502,9 +531,25 @@ TEST (Brackets, brackets_3) {
     x.push_back(1);
     x.push_back(2);
     x.push_front(3);
-    ASSERT_TRUE(x[10] == 1);
-    ASSERT_TRUE(x[11] == 2);
-    ASSERT_TRUE(x[9] == 3);
+    ASSERT_TRUE(x[1] == 1);
+    ASSERT_TRUE(x[2] == 2);
+    ASSERT_TRUE(x[0] == 3);
+}
+
+TEST (Brackets, brackets_4) {
+    MyDeque<int> x;
+    for (int i = 0; i < 1000; ++i)
+        x.push_back(i);
+    for (int i = 1; i <= 1000; ++i)
+        x.push_front(-i);
+    for (int i = 0; i < 333; ++i)
+        x.pop_front();
+    ASSERT_TRUE(x.size() == 1667);
+    for (int i = 0; i < 1667; ++i)
+        ASSERT_TRUE(x[i] == *(x.begin() + i));
+    ASSERT_TRUE(x[666] == -1);
+    ASSERT_TRUE(x[667] == 0);
+    ASSERT_TRUE(x[1666] == 999);
 }
 
 
@@ -635,7 +680,7 @@ TEST (IteratorPreIncr, iterator_pre_incr_1) {
 
 TEST (IteratorPreIncr, iterator_pre_incr_2) {
 	MyDeque<int> x(2, 1);
-	MyDeque<int>::iterator i = x.begin() - 1;
+	MyDeque<int>::iterator i = x.end() - 2;
 	++i;
 	ASSERT_TRUE(*i == 1);
 }
@@ -717,3 +762,1812 @@ TEST (DequeEqualEqual, deque_equal_equal_3) {
     MyDeque<int> y(10);
     ASSERT_TRUE(x == y);
 }
+
+
+
+// *** SORT ***
+TEST (Sort, sort_1) {
+    MyDeque<int> x(25);
+    for (int i = 0; i < 25; ++i)
+        x[i] = 25 - i;
+    x.sort();
+    for (int i = 0; i < 25; ++i)
+        ASSERT_TRUE(x[i] == i + 1);
+}
+
+TEST (Sort, sort_2) {
+    MyDeque<int> x(200000);
+    MyDeque<int>::iterator b = x.begin();
+    for (int i = 0; i < 200000; ++i)
+        b[i] = (i * 7919) % 100003;
+    x.sort();
+    ASSERT_TRUE(x.size() == 200000);
+    ASSERT_TRUE(std::is_sorted(x.begin(), x.end()));
+}
+
+TEST (Sort, sort_3) {
+    MyDeque<int> x(30, 1);
+    x.pop_front();
+    x.pop_front();
+    x.pop_front();
+    MyDeque<int>::iterator b = x.begin();
+    for (int i = 0; i < 27; ++i)
+        b[i] = i;
+    x.sort(std::greater<int>());
+    ASSERT_TRUE(x.size() == 27);
+    ASSERT_TRUE(*x.begin() == 26);
+    ASSERT_TRUE(x.back() == 0);
+}
+
+TEST (Sort, sort_4) {
+    const size_t workers[] = {2, 3, 8};
+    const int    sizes[]   = {5 * 64 + 13, 9 * 64 + 40, 21 * 64 + 7};
+    int          odd       = 0;
+    for (size_t w = 0; w < 3; ++w)
+        for (int s = 0; s < 3; ++s) {
+            MyDeque<int> x;
+            std::vector<int> y;
+            for (int i = 0; i < sizes[s]; ++i) {
+                const int v = (i * 7919) % 1009;
+                if (i % 3 == 0)
+                    x.push_front(v);
+                else
+                    x.push_back(v);
+                y.push_back(v);}
+            ASSERT_TRUE(x.segment(0).second - x.segment(0).first < 64);    // first inner array partly used
+            odd += x.segments() % 2;
+            x.sort(std::less<int>(), workers[w]);
+            std::sort(y.begin(), y.end());
+            ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));}
+    ASSERT_TRUE(odd > 0);
+}
+
+
+
+// *** STABLE SORT ***
+TEST (StableSort, stable_sort_1) {
+    MyDeque<std::pair<int, int> > x(100000);
+    MyDeque<std::pair<int, int> >::iterator b = x.begin();
+    for (int i = 0; i < 100000; ++i)
+        b[i] = std::make_pair((i * 31) % 7, i);
+    x.stable_sort([] (const std::pair<int, int>& l, const std::pair<int, int>& r) {return l.first < r.first;});
+    for (int i = 1; i < 100000; ++i) {
+        ASSERT_TRUE(b[i - 1].first <= b[i].first);
+        if (b[i - 1].first == b[i].first) {
+            ASSERT_TRUE(b[i - 1].second < b[i].second);}}
+}
+
+TEST (StableSort, stable_sort_2) {
+    MyDeque<int> x(3, 2);
+    x.stable_sort();
+    ASSERT_TRUE(x.size() == 3);
+    ASSERT_TRUE(x[2] == 2);
+}
+
+TEST (StableSort, stable_sort_3) {
+    MyDeque<int> x;
+    x.stable_sort();
+    ASSERT_TRUE(x.size() == 0);
+}
+
+TEST (StableSort, stable_sort_4) {
+    // a comparator that throws in the merges must leave every element in place;
+    // std::stable_sort of an inner array promises less, so the throws start after those
+    std::vector<std::string> v;
+    for (int i = 0; i < 5000; ++i)
+        v.push_back(std::string(30, 'x') + std::to_string((i * 7919) % 5000));
+    const size_t b = MyDeque<std::string>::sizeArray;
+    int sorts = 0;
+    for (size_t i = 0; i < v.size(); i += b) {
+        std::vector<std::string> w(v.begin() + i, v.begin() + std::min(i + b, v.size()));
+        std::stable_sort(w.begin(), w.end(), [&sorts] (const std::string& l, const std::string& r) {
+            ++sorts;
+            return l < r;});}
+    std::vector<std::string> u(v);
+    std::sort(u.begin(), u.end());
+    int throws = 0;
+    for (int k = sorts + 1; ; k += 2999) {
+        MyDeque<std::string> x;
+        for (size_t i = 0; i < v.size(); ++i)
+            x.push_back(v[i]);
+        int calls = 0;
+        try {
+            x.stable_sort([&calls, k] (const std::string& l, const std::string& r) {
+                if (++calls == k)
+                    throw std::invalid_argument("compare");
+                return l < r;});}
+        catch (const std::invalid_argument&) {
+            ++throws;}
+        std::vector<std::string> w(x.begin(), x.end());             // none lost to the scratch buffer
+        std::sort(w.begin(), w.end());
+        ASSERT_TRUE(w == u);
+        if (calls < k)
+            break;}
+    ASSERT_TRUE(throws >= 5);
+}
+
+TEST (StableSort, stable_sort_5) {
+    const size_t workers[] = {2, 3, 8};
+    const int    sizes[]   = {5 * 64 + 13, 9 * 64 + 40, 21 * 64 + 7};
+    int          odd       = 0;
+    for (size_t w = 0; w < 3; ++w)
+        for (int s = 0; s < 3; ++s) {
+            MyDeque<std::pair<int, int> > x;
+            for (int i = 0; i < sizes[s]; ++i)
+                x.push_back(std::make_pair((i * 31) % 7, i));
+            for (int i = 0; i < 11; ++i)
+                x.push_front(std::make_pair((i * 13) % 7, -1 - i));     // seconds still rise front to back
+            ASSERT_TRUE(x.segment(0).second - x.segment(0).first < 64);    // first inner array partly used
+            odd += x.segments() % 2;
+            x.stable_sort([] (const std::pair<int, int>& l, const std::pair<int, int>& r) {return l.first < r.first;}, workers[w]);
+            ASSERT_TRUE(x.size() == size_t(sizes[s] + 11));
+            for (size_t i = 1; i < x.size(); ++i) {
+                ASSERT_TRUE(x[i - 1].first <= x[i].first);
+                if (x[i - 1].first == x[i].first) {
+                    ASSERT_TRUE(x[i - 1].second < x[i].second);}}}
+    ASSERT_TRUE(odd > 0);
+}
+
+
+
+// *** TRACE ***
+TEST (Trace, trace_1) {
+    {
+    DequeTraceWriter w("TestDeque.trace");
+    ASSERT_TRUE(w.good());
+    w.record(TRACE_PUSH_BACK, 0, 0);
+    w.record(TRACE_INDEX, 300, 1);
+    w.record(TRACE_RESIZE, 1u << 31, 70000);
+    }
+    DequeTraceReader r("TestDeque.trace");
+    DequeTraceRecord x;
+    ASSERT_TRUE(r.good());
+    ASSERT_TRUE(r.next(x));
+    ASSERT_TRUE((x.op == TRACE_PUSH_BACK) && (x.index == 0) && (x.size == 0));
+    ASSERT_TRUE(r.next(x));
+    ASSERT_TRUE((x.op == TRACE_INDEX) && (x.index == 300) && (x.size == 1));
+    ASSERT_TRUE(r.next(x));
+    ASSERT_TRUE((x.op == TRACE_RESIZE) && (x.index == (1u << 31)) && (x.size == 70000));
+    ASSERT_FALSE(r.next(x));
+    std::remove("TestDeque.trace");
+}
+
+TEST (Trace, trace_2) {
+    DequeTraceReader r("TestDeque.c++");
+    ASSERT_FALSE(r.good());
+}
+
+#ifdef DEQUE_TRACE
+TEST (Trace, trace_3) {
+    {
+    DequeTraceWriter w("TestDeque.trace");
+    MyDeque<int> x;
+    x.trace(&w);
+    x.push_back(1);
+    x.push_front(2);
+    x.at(1);
+    x.erase(x.begin());
+    x.trace(0);
+    x.push_back(3);
+    }
+    DequeTraceReader r("TestDeque.trace");
+    DequeTraceRecord x;
+    ASSERT_TRUE(r.next(x));
+    ASSERT_TRUE((x.op == TRACE_PUSH_BACK) && (x.size == 0));
+    ASSERT_TRUE(r.next(x));
+    ASSERT_TRUE((x.op == TRACE_PUSH_FRONT) && (x.size == 1));
+    ASSERT_TRUE(r.next(x));
+    ASSERT_TRUE((x.op == TRACE_AT) && (x.index == 1) && (x.size == 2));
+    ASSERT_TRUE(r.next(x));
+    ASSERT_TRUE((x.op == TRACE_ERASE) && (x.index == 0) && (x.size == 2));
+    ASSERT_FALSE(r.next(x));
+    std::remove("TestDeque.trace");
+}
+
+TEST (Trace, trace_4) {
+    {
+    DequeTraceWriter w("TestDeque.trace");
+    MyDeque<int> x(200, 1);
+    x.trace(&w);
+    x.pop_front_n(30);
+    x.stable_sort();
+    x.sort(std::greater<int>());
+    x.splice_back(MyDeque<int>(70, 2));
+    x.splice_front(MyDeque<int>(5, 3));
+    MyDeque<int> y = x.split_at(100);
+    x.push_back(4);
+    }
+    const unsigned char op[]    = {TRACE_POP_FRONT_N, TRACE_SORT, TRACE_SORT, TRACE_SPLICE_BACK,
+                                   TRACE_SPLICE_FRONT, TRACE_SPLIT_AT, TRACE_PUSH_BACK};
+    const size_t        index[] = {30, 1, 0, 70, 5, 100, 0};
+    const size_t        size[]  = {200, 170, 170, 170, 240, 245, 100};
+    DequeTraceReader r("TestDeque.trace");
+    DequeTraceRecord x;
+    for (int i = 0; i < 7; ++i) {                               // one record per call, none from inside
+        ASSERT_TRUE(r.next(x));
+        ASSERT_TRUE((x.op == op[i]) && (x.index == index[i]) && (x.size == size[i]));}
+    ASSERT_FALSE(r.next(x));
+    std::remove("TestDeque.trace");
+}
+#endif
+
+
+
+// *** ITERATOR LAYOUT ***
+TEST (IteratorLayout, iterator_layout_1) {
+    MyDeque<int> x(35);
+    MyDeque<int>::iterator b = x.begin();
+    for (int i = 0; i < 35; ++i)
+        b[i] = i;
+    int n = 0;
+    for (MyDeque<int>::iterator i = x.begin(); i != x.end(); ++i, ++n)
+        ASSERT_TRUE(*i == n);
+    ASSERT_TRUE(n == 35);
+    ASSERT_TRUE(x.end() - x.begin() == 35);
+    ASSERT_TRUE((x.begin() + 12) - (x.begin() + 29) == -17);
+    ASSERT_TRUE(x.begin() + 9 < x.begin() + 10);
+}
+
+TEST (IteratorLayout, iterator_layout_2) {
+    MyDeque<int> x(35);
+    MyDeque<int>::iterator b = x.begin();
+    for (int i = 0; i < 35; ++i)
+        b[i] = i;
+    const MyDeque<int>& y = x;
+    int n = 34;
+    MyDeque<int>::const_iterator i = y.end();
+    while (i != y.begin())
+        ASSERT_TRUE(*--i == n--);
+    ASSERT_TRUE(n == -1);
+    ASSERT_TRUE(*(y.begin() + 21) == 21);
+    ASSERT_TRUE(*(y.end() - 11) == 24);
+}
+
+TEST (IteratorLayout, iterator_layout_3) {
+    MyDeque<int> x;
+    ASSERT_TRUE(x.begin() == x.end());
+    ASSERT_TRUE(x.end() - x.begin() == 0);
+    #ifndef DEQUE_DEBUG
+    ASSERT_TRUE(sizeof(MyDeque<int>::iterator) == 2 * sizeof(int*));
+    #endif
+}
+
+#ifdef DEQUE_DEBUG
+TEST (IteratorDebug, iterator_debug_1) {
+    MyDeque<int> x(5);
+    EXPECT_DEATH(*x.end(), "");
+    EXPECT_DEATH(x.begin() + 6, "");
+}
+
+TEST (IteratorDebug, iterator_debug_2) {
+    MyDeque<int> x(10);
+    MyDeque<int>::iterator i = x.begin();
+    for (int j = 0; j != 1000; ++j)
+        x.push_back(j);
+    EXPECT_DEATH(*i, "");
+}
+
+TEST (IteratorDebug, iterator_debug_3) {
+    MyDeque<int> x(5);
+    MyDeque<int> y(5);
+    EXPECT_DEATH(x.begin() == y.begin(), "");
+    EXPECT_DEATH(x.end() - y.begin(), "");
+}
+#endif
+
+
+
+// *** BLOCK ALLOCATOR ***
+TEST (BlockAlloc, block_alloc_1) {
+    MyDeque<int, BlockAllocator<int> > x;
+    for (int i = 0; i < 1000; ++i)
+        x.push_back(i);
+    for (int i = 0; i < 1000; ++i)
+        x.push_front(-i);
+    ASSERT_TRUE(x.segments() >= 30);
+    for (size_t k = 1; k < x.segments(); ++k)                  // every inner array starts on a cache line
+        ASSERT_TRUE(reinterpret_cast<size_t>(x.segment(k).first) % 64 == 0);
+    ASSERT_TRUE(x.front() == -999);
+    ASSERT_TRUE(x.back() == 999);
+    MyDeque<int, BlockAllocator<int, 64, 0> > y(BlockAllocator<int, 64, 0>(std::make_shared<BlockArena>()));  // carves from the first allocation on
+    for (int i = 0; i < 1000; ++i)
+        y.push_back(i);
+    ASSERT_TRUE(y.get_allocator().arena().regions() == 1);
+    for (size_t k = 0; k < y.segments(); ++k) {
+        ASSERT_TRUE(y.get_allocator().arena().owns(y.segment(k).first));
+        ASSERT_TRUE(reinterpret_cast<size_t>(y.segment(k).first) % 64 == 0);}
+}
+
+TEST (BlockAlloc, block_alloc_2) {
+    MyDeque<int, BlockAllocator<int> > x;
+    int n = 0;
+    for (int i = 0; i < 10000; ++i) {
+        x.push_back(i);
+        if (i % 3 != 0) {
+            ASSERT_TRUE(x.front() == n);
+            x.pop_front();
+            ++n;}}
+    ASSERT_TRUE(x.size() == 10000u - n);
+    for (int i = n; i < 10000; ++i) {
+        ASSERT_TRUE(x.front() == i);
+        x.pop_front();}
+    ASSERT_TRUE(x.empty());
+}
+
+TEST (BlockAlloc, block_alloc_3) {
+    MyDeque<int, BlockAllocator<int, 64, 4096> > x(5000, 7);
+    ASSERT_TRUE(x.get_allocator().arena().regions() > 0);
+    MyDeque<int, BlockAllocator<int, 64, 4096> > y(x);
+    ASSERT_TRUE(x == y);
+    x.clear();
+    ASSERT_TRUE(y.size() == 5000u);
+    ASSERT_TRUE(y.back() == 7);
+}
+
+TEST (BlockAlloc, block_alloc_4) {
+    typedef MyDeque<int, BlockAllocator<int> > D;
+    D a;
+    D b;
+    ASSERT_TRUE(a.get_allocator() == b.get_allocator());       // default ones share an arena
+    for (int i = 0; i < 1000; ++i)
+        a.push_back(i);
+    const int* p = &a[500];
+    b = std::move(a);                                           // takes the storage, no copy
+    ASSERT_TRUE(a.empty() && (b.size() == 1000u) && (&b[500] == p));
+    D c;
+    c.swap(b);
+    ASSERT_TRUE(b.empty() && (&c[500] == p));
+    D d = c.split_at(640);
+    const int* q = &d[100];
+    c.splice_back(std::move(d));                                // relinked
+    ASSERT_TRUE(d.empty() && (&c[740] == q) && (&c[500] == p));
+    D e(BlockAllocator<int>(std::make_shared<BlockArena>()));   // an arena of its own
+    ASSERT_FALSE(e.get_allocator() == c.get_allocator());
+}
+
+TEST (BlockAlloc, block_alloc_5) {
+    typedef BlockAllocator<std::unique_ptr<int>, 64, 0> B;
+    typedef MyDeque<std::unique_ptr<int>, B>         D;
+    D a(B(std::make_shared<BlockArena>()));
+    D b(B(std::make_shared<BlockArena>()));
+    for (int i = 0; i < 100; ++i)
+        a.push_back(std::unique_ptr<int>(new int(i)));
+    b.push_back(std::unique_ptr<int>(new int(-1)));
+    a.swap(b);                                                  // unequal arenas, moved through a third deque
+    ASSERT_TRUE((a.size() == 1u) && (*a[0] == -1));
+    ASSERT_TRUE((b.size() == 100u) && (*b[0] == 0) && (*b[99] == 99));
+    ASSERT_TRUE(b.get_allocator().arena().owns(b.segment(0).first));
+    a = std::move(b);                                           // moved over, not copied
+    ASSERT_TRUE(b.empty() && (a.size() == 100u) && (*a[99] == 99));
+    ASSERT_TRUE(a.get_allocator().arena().owns(a.segment(0).first));
+}
+
+
+
+// *** RECORD DEQUE ***
+TEST (RecordDeq, record_deque_1) {
+    RecordDeque<> x;
+    ASSERT_TRUE(x.empty());
+    x.push_back(std::string("hello"));
+    x.push_back("", 0);
+    x.push_back(std::string("world!"));
+    ASSERT_TRUE(x.size() == 3);
+    ASSERT_TRUE(x.bytes() == 11);
+    ASSERT_TRUE(x.front().str() == "hello");
+    x.pop_front();
+    ASSERT_TRUE(x.front().empty());
+    x.pop_front();
+    ASSERT_TRUE(x.front() == RecordView(std::string("world!")));
+    x.pop_front();
+    ASSERT_TRUE(x.empty());
+    ASSERT_TRUE(x.bytes() == 0);
+}
+
+TEST (RecordDeq, record_deque_2) {
+    RecordDeque<> x(256);
+    std::deque<std::string> y;
+    for (int i = 0; i < 5000; ++i) {
+        std::string s(20 + (i * 37) % 300, char('a' + i % 26));
+        x.push_back(s);
+        y.push_back(s);
+        if (i % 3 == 2) {
+            ASSERT_TRUE(x.front().str() == y.front());
+            x.pop_front();
+            y.pop_front();}}
+    ASSERT_TRUE(x.size() == y.size());
+    while (!y.empty()) {
+        ASSERT_TRUE(x.front().str() == y.front());
+        x.pop_front();
+        y.pop_front();}
+    ASSERT_TRUE(x.empty());
+    ASSERT_TRUE(x.blocks() == 1);
+}
+
+TEST (RecordDeq, record_deque_3) {
+    RecordDeque<> x(64);
+    for (int i = 0; i < 100; ++i)
+        x.push_back(std::string(10, 'x'));
+    ASSERT_TRUE(x.blocks() == 25);
+    x.push_back(std::string(4096, 'y'));
+    ASSERT_TRUE(x.blocks() == 26);
+    x.clear();
+    ASSERT_TRUE(x.empty());
+    ASSERT_TRUE(x.blocks() == 1);
+    x.push_back(std::string(100, 'z'));
+    ASSERT_TRUE(x.front().size() == 100);
+    ASSERT_TRUE(x.front().data()[99] == 'z');
+}
+
+TEST (RecordDeq, record_deque_4) {
+    RecordDeque<> x;
+    std::vector<char> v(5, 'v');
+    const char a[] = {'a', 'b', 'c'};
+    x.push_back(std::span<const char>(v));
+    x.push_back(std::span<const char>(a));
+    x.push_back(std::span<const char>(a).subspan(1));
+    x.push_back(std::span<const char>());
+    ASSERT_TRUE(x.size() == 4);
+    ASSERT_TRUE(x.bytes() == 10);
+    ASSERT_TRUE(x.front().str() == "vvvvv");
+    x.pop_front();
+    ASSERT_TRUE(x.front().str() == "abc");
+    x.pop_front();
+    ASSERT_TRUE(x.front().str() == "bc");
+    x.pop_front();
+    ASSERT_TRUE(x.front().empty());
+}
+
+
+
+// *** SOA DEQUE ***
+TEST (SoADeq, soa_deque_1) {
+    SoADeque<long, double, int> x;
+    x.push_back(std::make_tuple(1L, 2.5, 3));
+    x.push_back(4L, 5.5, 6);
+    x.push_front(0L, 0.5, 0);
+    ASSERT_TRUE(x.size() == 3);
+    ASSERT_TRUE(std::get<0>(x.front()) == 0);
+    ASSERT_TRUE(std::get<1>(x[1]) == 2.5);
+    ASSERT_TRUE(std::get<2>(x.back()) == 6);
+    std::get<2>(x[1]) = 30;
+    ASSERT_TRUE(x.column<2>()[1] == 30);
+    x.pop_front();
+    x.pop_back();
+    ASSERT_TRUE(x[0] == std::make_tuple(1L, 2.5, 30));
+}
+
+TEST (SoADeq, soa_deque_2) {
+    SoADeque<long, int> x;
+    for (int i = 0; i < 1000; ++i)
+        x.push_back(i, -i);
+    for (int i = 0; i < 100; ++i)
+        x.pop_front();
+    long s = 0;
+    size_t n = 0;
+    for (size_t k = 0; k != x.segments(); ++k) {
+        std::pair<long*, long*> r = x.segment<0>(k);
+        std::pair<int*, int*>   q = x.segment<1>(k);
+        ASSERT_TRUE(r.second - r.first == q.second - q.first);
+        for (long* p = r.first; p != r.second; ++p)
+            s += *p;
+        n += r.second - r.first;}
+    ASSERT_TRUE(n == 900);
+    ASSERT_TRUE(s == 1000L * 999 / 2 - 100L * 99 / 2);
+}
+
+TEST (SoADeq, soa_deque_3) {
+    SoADeque<int, char> x;
+    for (int i = 0; i < 100; ++i)
+        x.push_back(i, char('a' + i % 26));
+    SoADeque<int, char>::iterator b = x.begin();
+    ASSERT_TRUE(x.end() - b == 100);
+    ASSERT_TRUE(std::get<1>(b[27]) == 'b');
+    for (SoADeque<int, char>::iterator i = x.begin(); i != x.end(); ++i)
+        std::get<0>(*i) *= 2;
+    ASSERT_TRUE(std::get<0>(*(b + 50)) == 100);
+    SoADeque<int, char> y;
+    y.swap(x);
+    ASSERT_TRUE(x.empty());
+    ASSERT_TRUE(y.size() == 100);
+    y.clear();
+    ASSERT_TRUE(y.segments() == 0);
+}
+
+
+
+// *** ASYNC DEQUE ***
+AsyncTask async_consume (AsyncDeque<int>& q, int n, std::vector<int>& out) {
+    for (int i = 0; i < n; ++i)
+        out.push_back(co_await q.pop_front());}
+
+AsyncTask async_produce (AsyncDeque<int>& q, int b, int e) {
+    for (int i = b; i < e; ++i)
+        co_await q.push_back(i);}
+
+AsyncTask async_consume_some (AsyncDeque<int>& q, int n, std::vector<size_t>& batches) {
+    int got = 0;
+    while (got < n) {
+        std::vector<int> r = co_await q.pop_some(4);
+        batches.push_back(r.size());
+        got += r.size();}}
+
+TEST (AsyncDeq, async_deque_1) {
+    AsyncLoop       l;
+    AsyncDeque<int> q(l);
+    std::vector<int> a;
+    std::vector<int> b;
+    async_consume(q, 2, a);
+    async_consume(q, 2, b);
+    ASSERT_TRUE(q.consumers() == 2);
+    async_produce(q, 0, 4);
+    ASSERT_TRUE(q.consumers() == 0);
+    ASSERT_TRUE(q.size() == 2);
+    l.run();
+    ASSERT_TRUE(a == std::vector<int>({0, 2}));
+    ASSERT_TRUE(b == std::vector<int>({1, 3}));
+    ASSERT_TRUE(q.empty());
+}
+
+TEST (AsyncDeq, async_deque_2) {
+    AsyncLoop       l;
+    AsyncDeque<int> q(l, 3);
+    async_produce(q, 0, 10);
+    ASSERT_TRUE(q.size() == 3);
+    ASSERT_TRUE(q.producers() == 1);
+    async_produce(q, 100, 102);
+    ASSERT_TRUE(q.producers() == 2);
+    std::vector<int> a;
+    async_consume(q, 12, a);
+    l.run();
+    ASSERT_TRUE(a.size() == 12);
+    for (int i = 0; i < 3; ++i)
+        ASSERT_TRUE(a[i] == i);
+    ASSERT_TRUE(a[3] == 3);
+    ASSERT_TRUE(a[4] == 100);
+    ASSERT_TRUE(a[5] == 4);
+    ASSERT_TRUE(std::count(a.begin(), a.end(), 101) == 1);
+    ASSERT_TRUE((q.producers() == 0) && (q.consumers() == 0) && q.empty());
+}
+
+TEST (AsyncDeq, async_deque_3) {
+    AsyncLoop       l;
+    AsyncDeque<int> q(l);
+    std::vector<size_t> batches;
+    async_consume_some(q, 10, batches);
+    async_produce(q, 0, 10);
+    l.run();
+    ASSERT_TRUE(batches == std::vector<size_t>({4, 4, 2}));
+    ASSERT_TRUE(q.empty());
+}
+
+
+
+// *** CHANNEL ***
+TEST (Chan, channel_1) {
+    Channel<int> c(4);
+    ASSERT_TRUE(c.push(1));
+    ASSERT_TRUE(c.try_push(0));
+    ASSERT_TRUE(c.size() == 2);
+    ASSERT_TRUE(c.try_push(6));
+    ASSERT_TRUE(c.try_push(7));
+    ASSERT_FALSE(c.try_push(8));
+    ASSERT_TRUE(c.size() == 4);
+    int v;
+    std::vector<int> out;
+    ASSERT_TRUE(c.pop_n(std::back_inserter(out), 3) == 3);
+    ASSERT_TRUE(out == std::vector<int>({1, 0, 6}));
+    ASSERT_TRUE(c.pop(v) && (v == 7));
+    ASSERT_FALSE(c.try_pop(v));
+    int a[] = {2, 3, 4, 5};
+    ASSERT_TRUE(c.push_n(a, a + 4) == 4);
+    ASSERT_TRUE(c.size() == 4);
+}
+
+TEST (Chan, channel_2) {
+    Channel<int> c(8);
+    int a[] = {1, 2, 3};
+    ASSERT_TRUE(c.push_n(a, a + 3) == 3);
+    c.close();
+    ASSERT_TRUE(c.closed());
+    ASSERT_FALSE(c.push(4));
+    ASSERT_FALSE(c.try_push(4));
+    int v;
+    ASSERT_TRUE(c.pop(v) && (v == 1));
+    std::vector<int> out;
+    ASSERT_TRUE(c.pop_n(std::back_inserter(out), 10) == 2);
+    ASSERT_FALSE(c.pop(v));
+    ASSERT_TRUE(c.pop_n(std::back_inserter(out), 10) == 0);
+}
+
+TEST (Chan, channel_3) {
+    Channel<long> c(16);
+    const int producers = 4;
+    const int consumers = 3;
+    const long n = 20000;
+    std::vector<std::thread> t;
+    std::vector<long> sums(consumers, 0);
+    for (int p = 0; p < producers; ++p)
+        t.push_back(std::thread([&c, p, n] () {
+            std::vector<long> batch;
+            for (long i = 1; i <= n; ++i) {
+                batch.push_back(i * producers + p);
+                if (batch.size() == 7) {
+                    c.push_n(batch.begin(), batch.end());
+                    batch.clear();}}
+            c.push_n(batch.begin(), batch.end());}));
+    for (int k = 0; k < consumers; ++k)
+        t.push_back(std::thread([&c, &sums, k] () {
+            long buf[5];
+            size_t got;
+            while ((got = c.pop_n(buf, 5)) != 0)
+                for (size_t i = 0; i < got; ++i)
+                    sums[k] += buf[i];}));
+    for (int p = 0; p < producers; ++p)
+        t[p].join();
+    c.close();
+    for (int k = 0; k < consumers; ++k)
+        t[producers + k].join();
+    long s = 0;
+    for (int k = 0; k < consumers; ++k)
+        s += sums[k];
+    long expected = 0;
+    for (int p = 0; p < producers; ++p)
+        for (long i = 1; i <= n; ++i)
+            expected += i * producers + p;
+    ASSERT_TRUE(s == expected);
+    ASSERT_TRUE(c.size() == 0);
+}
+
+TEST (Chan, channel_4) {
+    Channel<std::unique_ptr<int> > c(4);
+    std::unique_ptr<int> p(new int(1));
+    ASSERT_TRUE(c.push(std::move(p)));
+    ASSERT_TRUE(!p);
+    p.reset(new int(2));
+    ASSERT_TRUE(c.try_push(std::move(p)));
+    ASSERT_TRUE(!p);
+    std::unique_ptr<int> a[2] = {std::unique_ptr<int>(new int(3)), std::unique_ptr<int>(new int(4))};
+    ASSERT_TRUE(c.push_n(std::make_move_iterator(a), std::make_move_iterator(a + 2)) == 2);
+    ASSERT_TRUE(!a[0] && !a[1]);
+    p.reset(new int(5));
+    ASSERT_TRUE(!c.try_push(std::move(p)));
+    ASSERT_TRUE(p && (*p == 5));
+    ASSERT_TRUE(c.pop(p));
+    ASSERT_TRUE(*p == 1);
+    ASSERT_TRUE(c.try_pop(p));
+    ASSERT_TRUE(*p == 2);
+    std::unique_ptr<int> b[2];
+    ASSERT_TRUE(c.pop_n(b, 2) == 2);
+    ASSERT_TRUE((*b[0] == 3) && (*b[1] == 4));
+    c.close();
+    p.reset(new int(6));
+    ASSERT_TRUE(!c.push(std::move(p)));
+    ASSERT_TRUE(p && (*p == 6));
+    ASSERT_TRUE(!c.try_pop(p));
+    ASSERT_TRUE(*p == 6);
+}
+
+
+
+// *** WINDOW ***
+TEST (Window, window_1) {
+    MinWindow<int> lo;
+    MaxWindow<int> hi;
+    std::vector<int> v;
+    for (int i = 0; i < 2000; ++i) {
+        const int x = (i * 7919) % 1009;
+        v.push_back(x);
+        lo.push(x);
+        hi.push(x);
+        lo.keep_last(50);
+        hi.keep_last(50);
+        std::vector<int>::iterator b = v.end() - std::min(i + 1, 50);
+        ASSERT_TRUE(lo.top() == *std::min_element(b, v.end()));
+        ASSERT_TRUE(hi.top() == *std::max_element(b, v.end()));}
+}
+
+struct Concat {
+    std::string operator () (const std::string& lhs, const std::string& rhs) const {
+        return lhs + rhs;}};
+
+TEST (Window, window_2) {
+    AggregateWindow<std::string, Concat, int> x;
+    x.push("a", 10);
+    x.push("b", 20);
+    x.push("c", 30);
+    ASSERT_TRUE(x.value() == "abc");
+    x.evict_before(15);
+    ASSERT_TRUE(x.value() == "bc");
+    x.push("d", 40);
+    x.push("e", 50);
+    ASSERT_TRUE(x.value() == "bcde");
+    x.evict_before(35);
+    ASSERT_TRUE(x.size() == 2);
+    ASSERT_TRUE(x.front() == "d");
+    ASSERT_TRUE(x.value() == "de");
+    x.evict_before(100);
+    ASSERT_TRUE(x.empty());
+}
+
+TEST (Window, window_3) {
+    AggregateWindow<long> sum;
+    MaxWindow<double, double> hi;
+    long s = 0;
+    for (long i = 1; i <= 1000; ++i) {
+        sum.push(i);
+        s += i;
+        if (sum.size() > 100) {
+            s -= sum.front();
+            sum.pop();}
+        ASSERT_TRUE(sum.value() == s);
+        hi.push(1000.0 - i, i * 0.5);
+        hi.evict_before(i * 0.5 - 10);}
+    ASSERT_TRUE(sum.value() / sum.size() == 950);
+    ASSERT_TRUE(hi.top() == 20.0);
+}
+
+TEST (Window, window_4) {
+    AggregateWindow<double, std::plus<double>, int> x;
+    x.push(1.0, 1);
+    ASSERT_TRUE(x.mean() == 1.0);
+    x.push(2.0, 2);
+    x.push(6.0, 3);
+    ASSERT_TRUE(x.mean() == 3.0);
+    x.keep_last(2);
+    ASSERT_TRUE(x.mean() == 4.0);
+    x.push(10.0, 4);
+    x.evict_before(3);
+    ASSERT_TRUE(x.size() == 2);
+    ASSERT_TRUE(x.mean() == 8.0);
+    AggregateWindow<long> y;
+    for (long i = 1; i <= 10; ++i)
+        y.push(i);
+    ASSERT_TRUE(y.mean() == 5);                                 // integer division, like value() / size()
+}
+
+
+
+// *** SPLICE ***
+template <typename D>
+bool holds (const D& x, int b, int e) {
+    if (x.size() != size_t(e - b))
+        return false;
+    for (typename D::const_iterator i = x.begin(); i != x.end(); ++i, ++b)
+        if (*i != b)
+            return false;
+    return true;}
+
+TEST (Splice, splice_1) {
+    MyDeque<int> x;
+    for (int i = 0; i < 1000; ++i)
+        x.push_back(i);
+    for (size_t pos = 0; pos <= 1000; pos += 37) {
+        MyDeque<int> y(x);
+        MyDeque<int> z = y.split_at(pos);
+        ASSERT_TRUE(holds(y, 0, pos));
+        ASSERT_TRUE(holds(z, pos, 1000));
+        y.splice_back(std::move(z));
+        ASSERT_TRUE(z.empty());
+        ASSERT_TRUE(y == x);}
+}
+
+TEST (Splice, splice_2) {
+    MyDeque<int> x;
+    for (int i = 300; i < 1000; ++i)
+        x.push_back(i);
+    for (int i = 299; i >= 0; --i)
+        x.push_front(i);
+    MyDeque<int> y = x.split_at(550);
+    MyDeque<int> w = x.split_at(100);
+    ASSERT_TRUE(holds(x, 0, 100));
+    ASSERT_TRUE(holds(w, 100, 550));
+    ASSERT_TRUE(holds(y, 550, 1000));
+    const int* p = &y[0];
+    y.splice_front(std::move(w));
+    ASSERT_TRUE(&y[450] == p);
+    ASSERT_TRUE(w.empty());
+    MyDeque<int> z;
+    for (int i = 0; i < 3; ++i)
+        z.push_back(-1);
+    z.splice_back(std::move(x));
+    z.splice_front(MyDeque<int>(5, -2));
+    ASSERT_TRUE(z.size() == 108);
+    y.splice_front(std::move(z));
+    ASSERT_TRUE(y.size() == 1008);
+    ASSERT_TRUE(y[7] == -1);
+    ASSERT_TRUE(y[8] == 0);
+    ASSERT_TRUE(y.back() == 999);
+    for (int i = 0; i < 900; ++i)
+        ASSERT_TRUE(y[i + 108] == i + 100);
+}
+
+TEST (Splice, splice_3) {
+    MyDeque<int> x;
+    MyDeque<int> y;
+    for (int i = 0; i < 100; ++i)
+        y.push_back(i);
+    x.splice_back(std::move(y));
+    ASSERT_TRUE(holds(x, 0, 100));
+    ASSERT_TRUE(y.empty());
+    y.push_back(-1);
+    x.splice_front(std::move(y));
+    ASSERT_TRUE(x.front() == -1);
+    MyDeque<int, BlockAllocator<int> > a;
+    MyDeque<int, BlockAllocator<int> > b;
+    a.push_back(1);
+    b.push_back(2);
+    b.push_back(3);
+    a.splice_back(std::move(b));
+    ASSERT_TRUE((a.size() == 3) && (a.back() == 3) && b.empty());
+    MyDeque<int, BlockAllocator<int> > c = a.split_at(1);
+    ASSERT_TRUE((a.size() == 1) && (c.front() == 2));
+}
+
+TEST (Splice, splice_4) {
+    const int sizes[] = {0, 1, 5, 63, 64, 65, 130, 300};
+    for (int f = 0; f < 8; ++f)
+        for (int g = 0; g < 8; ++g)
+            for (int back = 0; back < 2; ++back) {
+                MyDeque<std::string>   x;
+                MyDeque<std::string>   y;
+                std::deque<std::string> r;
+                for (int i = 0; i < sizes[f]; ++i)
+                    x.push_front(std::string(20, char('a' + i % 26)) + std::to_string(i));
+                for (int i = 0; i < sizes[g]; ++i)
+                    y.push_back(std::string(20, char('A' + i % 26)) + std::to_string(i));
+                if (back) {
+                    r.assign(x.begin(), x.end());
+                    r.insert(r.end(), y.begin(), y.end());
+                    x.splice_back(std::move(y));}
+                else {
+                    r.assign(y.begin(), y.end());
+                    r.insert(r.end(), x.begin(), x.end());
+                    x.splice_front(std::move(y));}
+                ASSERT_TRUE(y.empty());
+                ASSERT_TRUE(std::equal(x.begin(), x.end(), r.begin(), r.end()));
+                x.push_back("z");
+                x.push_front("z");
+                ASSERT_TRUE((x.size() == r.size() + 2) && (x.front() == "z") && (x.back() == "z"));}
+}
+
+
+
+// *** HANDLE DEQUE ***
+TEST (HandleDeq, handle_deque_1) {
+    HandleDeque<int> x;
+    DequeHandle a = x.push_back(1);
+    DequeHandle b = x.push_back(2);
+    DequeHandle c = x.push_front(0);
+    ASSERT_TRUE(*x.get(a) == 1);
+    ASSERT_TRUE(*x.get(c) == 0);
+    x.pop_front();
+    ASSERT_TRUE(x.get(c) == 0);
+    ASSERT_TRUE(*x.get(b) == 2);
+    *x.get(b) = 20;
+    ASSERT_TRUE(x.back() == 20);
+    x.pop_back();
+    x.pop_back();
+    ASSERT_TRUE(x.empty());
+    ASSERT_TRUE((x.get(a) == 0) && (x.get(b) == 0));
+    DequeHandle d = x.push_back(3);
+    ASSERT_FALSE(d == a);
+    ASSERT_TRUE(x.get(a) == 0);
+    ASSERT_TRUE(x.get(DequeHandle()) == 0);
+    ASSERT_TRUE(*x.get(DequeHandle::from_value(d.value())) == 3);
+}
+
+TEST (HandleDeq, handle_deque_2) {
+    HandleDeque<std::string> x;
+    std::vector<DequeHandle> h;
+    for (int i = 0; i < 10; ++i)
+        h.push_back(x.push_back(std::string(1, char('a' + i))));
+    ASSERT_TRUE(x.cancel(h[3]));
+    ASSERT_FALSE(x.cancel(h[3]));
+    ASSERT_TRUE(x.cancel(h[4]));
+    ASSERT_TRUE(x.cancel(h[0]));
+    ASSERT_TRUE(x.cancel(h[9]));
+    ASSERT_TRUE(x.size() == 6);
+    ASSERT_TRUE(x.slots() == 8);
+    ASSERT_TRUE(x.front() == "b");
+    ASSERT_TRUE(x.back() == "i");
+    x.pop_front();
+    x.pop_front();
+    ASSERT_TRUE(x.front() == "f");
+    ASSERT_TRUE(x.slots() == 4);
+    ASSERT_TRUE(x.get(h[4]) == 0);
+    ASSERT_TRUE(*x.get(h[7]) == "h");
+}
+
+TEST (HandleDeq, handle_deque_3) {
+    HandleDeque<int> x;
+    DequeHandle a = x.push_back(1);
+    x.clear();
+    ASSERT_TRUE(x.get(a) == 0);
+    DequeHandle b = x.push_back(2);
+    ASSERT_TRUE(x.get(a) == 0);
+    ASSERT_FALSE(x.cancel(a));
+    ASSERT_TRUE(*x.get(b) == 2);
+    ASSERT_TRUE(x.cancel(b));
+    ASSERT_TRUE(x.empty() && (x.slots() == 0));
+}
+
+TEST (HandleDeq, handle_deque_4) {
+    const uint64_t wrap = uint64_t(1) << 40;                    // sequence numbers are modulo 2^40
+    HandleDeque<int> x(std::allocator<int>(), wrap - 5);
+    std::vector<DequeHandle> h;
+    for (int i = 0; i < 10; ++i)
+        h.push_back(x.push_back(i));
+    for (int i = 0; i < 3; ++i)
+        h.insert(h.begin(), x.push_front(-1 - i));
+    for (int i = 0; i < 9; ++i)
+        x.pop_front();                                          // the front crosses the wrap
+    for (int i = 0; i < 9; ++i)
+        ASSERT_TRUE(x.get(h[i]) == 0);
+    for (int i = 9; i < 13; ++i)
+        ASSERT_TRUE(*x.get(h[i]) == i - 3);
+    ASSERT_TRUE(x.cancel(h[10]));
+    ASSERT_TRUE(x.get(h[10]) == 0);
+    ASSERT_TRUE(*x.get(h[11]) == 8);
+    ASSERT_TRUE(x.size() == 3);
+    HandleDeque<int> y(std::allocator<int>(), 1);
+    DequeHandle a = y.push_back(1);
+    DequeHandle b = y.push_front(2);
+    DequeHandle c = y.push_front(3);                            // below 0, wraps to 2^40 - 1
+    ASSERT_TRUE((*y.get(a) == 1) && (*y.get(b) == 2) && (*y.get(c) == 3));
+}
+
+
+
+// *** EXPIRY QUEUE ***
+TEST (Expiry, expiry_1) {
+    MyDeque<std::string> x;
+    for (int i = 0; i < 300; ++i)
+        x.push_back(std::to_string(i));
+    x.pop_front_n(0);
+    ASSERT_TRUE(x.size() == 300);
+    x.pop_front_n(1);
+    ASSERT_TRUE(x.front() == "1");
+    x.pop_front_n(150);
+    ASSERT_TRUE(x.front() == "151");
+    ASSERT_TRUE(x[100] == "251");
+    x.pop_front_n(149);
+    ASSERT_TRUE(x.empty());
+    x.push_back("a");
+    x.push_front("b");
+    ASSERT_TRUE((x.size() == 2) && (x.front() == "b"));
+}
+
+TEST (Expiry, expiry_2) {
+    ExpiryQueue< std::pair<int, int> > x;
+    for (int i = 0; i < 1000; ++i)
+        x.push(std::make_pair(i / 10, i));
+    ASSERT_TRUE(x.expiring(-1) == 0);
+    ASSERT_TRUE(x.expire_until(-1) == 0);
+    ASSERT_TRUE(x.expiring(4) == 50);
+    ASSERT_TRUE(x.expire_until(4) == 50);
+    ASSERT_TRUE(x.front().second == 50);
+    ASSERT_TRUE(x.expire_until(4) == 0);
+    ASSERT_TRUE(x.expire_until(77) == 730);
+    ASSERT_TRUE(x.front() == std::make_pair(78, 780));
+    ASSERT_TRUE(x.expire_until(1000) == 220);
+    ASSERT_TRUE(x.empty());
+    for (int i = 0; i < 3; ++i)
+        x.push(std::make_pair(i, i));
+    int seen = 0;
+    ASSERT_TRUE(x.expire_until(0, [&seen] (const std::pair<int, int>* b, const std::pair<int, int>* e) {
+        seen += int(e - b);}) == 1);                            // just the front
+    ASSERT_TRUE((seen == 1) && (x.front().first == 1));
+    ASSERT_TRUE(x.expire_until(1) == 1);
+    ASSERT_TRUE(x.expire_until(5) == 1);
+    ASSERT_TRUE(x.empty());
+}
+
+TEST (Expiry, expiry_3) {
+    ExpiryQueue< std::pair<long, std::string> > x;
+    for (long i = 0; i < 200; ++i)
+        x.push(std::make_pair(i, std::to_string(i)));
+    x.expire_until(9);
+    std::vector<std::string> v;
+    size_t runs = 0;
+    size_t n = x.expire_until(149, [&] (const std::pair<long, std::string>* b, const std::pair<long, std::string>* e) {
+        ++runs;
+        for (; b != e; ++b)
+            v.push_back(b->second);});
+    ASSERT_TRUE(n == 140);
+    ASSERT_TRUE(v.size() == 140);
+    ASSERT_TRUE((v.front() == "10") && (v.back() == "149"));
+    ASSERT_TRUE(runs >= 3);
+    ASSERT_TRUE(x.front().second == "150");
+    ASSERT_TRUE(x.expire_until(149, [&] (const std::pair<long, std::string>*, const std::pair<long, std::string>*) {++runs;}) == 0);
+    ASSERT_TRUE(x.size() == 50);
+}
+
+
+
+// *** COMPRESSED DEQUE ***
+TEST (Compressed, compressed_1) {
+    CompressedDeque<> x;
+    std::deque<uint64_t> y;
+    uint64_t v = 1000000000000ULL;
+    for (int i = 0; i < 1000; ++i) {
+        v += i % 7;
+        x.push_back(v);
+        y.push_back(v);
+        if (i % 3 == 0) {
+            ASSERT_TRUE(x.front() == y.front());
+            x.pop_front();
+            y.pop_front();}
+        ASSERT_TRUE((x.size() == y.size()) && (y.empty() || (x.back() == y.back())));}
+    while (!y.empty()) {
+        ASSERT_TRUE(x.front() == y.front());
+        x.pop_front();
+        y.pop_front();}
+    ASSERT_TRUE(x.empty() && (x.blocks() == 0));
+}
+
+TEST (Compressed, compressed_2) {
+    CompressedDeque<uint32_t> x;
+    std::vector<uint32_t> y;
+    uint32_t v = 7;
+    for (int i = 0; i < 2000; ++i) {
+        v = v * 1103515245u + 12345u;
+        const uint32_t w = (i % 500 < 250) ? v : uint32_t(i % 3);
+        x.push_back(w);
+        y.push_back(w);}
+    for (int i = 0; i < 100; ++i) {
+        x.pop_front();
+        y.erase(y.begin());}
+    ASSERT_TRUE(x.size() == y.size());
+    for (size_t i = 0; i < y.size(); ++i)
+        ASSERT_TRUE(x[i] == y[i]);
+    ASSERT_TRUE(x.at(y.size() - 1) == y.back());
+    ASSERT_THROW(x.at(y.size()), std::out_of_range);
+}
+
+TEST (Compressed, compressed_3) {
+    CompressedDeque<> x;
+    const size_t n = 100000;
+    for (uint64_t i = 0; i < n; ++i)
+        x.push_back(1700000000000ULL + 3 * i + (i % 2));
+    ASSERT_TRUE(x.blocks() > 700);
+    ASSERT_TRUE(x.bytes() * 8 < n * sizeof(uint64_t));
+    ASSERT_TRUE(x[n / 2] == 1700000000000ULL + 3 * (n / 2));
+    x.clear();
+    ASSERT_TRUE(x.empty() && (x.size() == 0));
+    x.push_back(5);
+    ASSERT_TRUE((x.front() == 5) && (x.back() == 5));
+}
+
+// fails every allocation while failing is set
+template <typename T>
+struct FailingAllocator {
+    typedef T value_type;
+
+    static bool failing;
+
+    FailingAllocator ()
+        {}
+
+    template <typename U>
+    FailingAllocator (const FailingAllocator<U>&)
+        {}
+
+    T* allocate (size_t n) {
+        if (failing)
+            throw std::bad_alloc();
+        return std::allocator<T>().allocate(n);}
+
+    void deallocate (T* p, size_t n) {
+        std::allocator<T>().deallocate(p, n);}};
+
+template <typename T>
+bool FailingAllocator<T>::failing = false;
+
+template <typename T, typename U>
+bool operator == (const FailingAllocator<T>&, const FailingAllocator<U>&) {
+    return true;}
+
+TEST (Compressed, compressed_4) {
+    typedef CompressedDeque<uint64_t, FailingAllocator<uint64_t> > D;
+    D x;
+    const size_t b = D::blockSize;
+    for (uint64_t i = 0; i < b; ++i)                            // the first one goes to the head
+        x.push_back(3 * i);
+    FailingAllocator<uint64_t>::failing = true;
+    ASSERT_THROW(x.push_back(3 * b), std::bad_alloc);           // packing the full tail fails
+    FailingAllocator<uint64_t>::failing = false;
+    ASSERT_TRUE((x.size() == b) && (x.blocks() == 0));
+    ASSERT_TRUE(x.back() == 3 * (b - 1));
+    for (uint64_t i = b; i < 4 * b; ++i)
+        x.push_back(3 * i);
+    ASSERT_TRUE(x.size() == 4 * b);
+    for (uint64_t i = 0; i < 4 * b; ++i)
+        ASSERT_TRUE(x[i] == 3 * i);
+}
+
+
+
+// *** BOOL DEQUE ***
+TEST (BoolDeq, bool_deque_1) {
+    MyDeque<bool> x;
+    std::deque<bool> y;
+    for (int i = 0; i < 1000; ++i) {
+        const bool v = (i * 7) % 3 == 0;
+        if (i % 4 == 0) {
+            x.push_front(v);
+            y.push_front(v);}
+        else {
+            x.push_back(v);
+            y.push_back(v);}
+        if (i % 5 == 0) {
+            x.pop_front();
+            y.pop_front();}
+        if ((i % 11 == 0) && !y.empty()) {
+            x.pop_back();
+            y.pop_back();}}
+    ASSERT_TRUE(x.size() == y.size());
+    ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+    x[3] = !x[3];
+    x.front() = true;
+    x.back() = x.front();
+    ASSERT_TRUE(x[3] != y[3]);
+    ASSERT_TRUE(x.front() && x.back());
+    MyDeque<bool>::iterator p = x.begin() + 10;
+    *p = false;
+    ASSERT_FALSE(x[10]);
+    ASSERT_TRUE((x.end() - p) == ptrdiff_t(x.size() - 10));
+    while (!x.empty())
+        x.pop_back();
+    ASSERT_TRUE(x.bytes() == 0);
+}
+
+TEST (BoolDeq, bool_deque_2) {
+    MyDeque<bool> x(300);
+    ASSERT_TRUE(x.count() == 0);
+    ASSERT_TRUE(x.count(false) == 300);
+    ASSERT_TRUE(x.find_first() == 300);
+    x[299] = true;
+    ASSERT_TRUE(x.find_first() == 299);
+    x[70] = true;
+    ASSERT_TRUE(x.find_first() == 70);
+    for (int i = 0; i < 37; ++i)
+        x.pop_front();
+    x.push_front(false);
+    ASSERT_TRUE(x.find_first() == 34);
+    ASSERT_TRUE(x.count() == 2);
+    MyDeque<bool> y(100, true);
+    y.pop_front();
+    y.push_back(false);
+    ASSERT_TRUE(y.find_first(false) == 99);
+    ASSERT_TRUE(y.count() == 99);
+    ASSERT_TRUE(y.count(false) == 1);
+}
+
+TEST (BoolDeq, bool_deque_3) {
+    MyDeque<bool> x(10000, true);
+    ASSERT_TRUE(x.bytes() == (10000 + 63) / 64 * 8);
+    x.resize(130);
+    ASSERT_TRUE((x.size() == 130) && (x.count() == 130));
+    x.resize(200, false);
+    ASSERT_TRUE(x.count() == 130);
+    x.resize(400, true);
+    ASSERT_TRUE(x.count() == 330);
+    ASSERT_TRUE(x.find_first(false) == 130);
+    MyDeque<bool> y(x);
+    ASSERT_TRUE(x == y);
+    y[0] = false;
+    ASSERT_TRUE(y < x);
+    y.swap(x);
+    ASSERT_FALSE(x[0]);
+    ASSERT_THROW(x.at(400), std::out_of_range);
+}
+
+TEST (BoolDeq, bool_deque_4) {
+    MyDeque<bool>    x;
+    std::deque<bool> y;
+    x.incremental_growth(true);
+    ASSERT_TRUE(x.incremental_growth());
+    for (int i = 0; i < 3000; ++i) {
+        const bool v = (i * 13) % 5 < 2;
+        const size_t k = (i * 7919) % (y.size() + 1);
+        if ((i % 3 == 0) && !y.empty() && (k < y.size())) {
+            ASSERT_TRUE(x.erase(x.begin() + k) == x.begin() + k);
+            y.erase(y.begin() + k);}
+        else {
+            ASSERT_TRUE(*x.insert(x.begin() + k, v) == v);
+            y.insert(y.begin() + k, v);}}
+    ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin(), y.end()));
+    MyDeque<bool> z = x.split_at(777);
+    ASSERT_TRUE((x.size() == 777) && std::equal(z.begin(), z.end(), y.begin() + 777, y.end()));
+    x.splice_back(std::move(z));
+    ASSERT_TRUE(z.empty() && std::equal(x.begin(), x.end(), y.begin(), y.end()));
+    z = x.split_at(100);
+    z.splice_front(std::move(x));
+    ASSERT_TRUE(x.empty() && std::equal(z.begin(), z.end(), y.begin(), y.end()));
+    z.sort();
+    std::sort(y.begin(), y.end());
+    ASSERT_TRUE(std::equal(z.begin(), z.end(), y.begin(), y.end()));
+    z.stable_sort(std::greater<bool>());
+    ASSERT_TRUE(z.front() && !z.back() && (z.find_first(false) == z.count()));
+}
+
+TEST (BoolDeq, bool_deque_5) {
+    MyDeque<bool> a(100, true);
+    MyDeque<bool> b(std::move(a));
+    ASSERT_TRUE(a.empty() && (a.bytes() == 0) && (b.count() == 100));
+    a.push_back(true);                                          // a moved-from deque is an empty one
+    a.push_front(false);
+    ASSERT_TRUE((a.size() == 2) && a.back() && !a.front());
+    MyDeque<bool> c(70, false);
+    c = std::move(b);
+    ASSERT_TRUE(b.empty() && (c.size() == 100) && (c.count() == 100));
+    b.push_back(false);
+    ASSERT_TRUE((b.size() == 1) && !b[0]);
+    b = c;
+    ASSERT_TRUE((b == c) && (c.size() == 100));
+}
+
+
+
+// *** APPEND LOG ***
+TEST (AppendLg, append_log_1) {
+    AppendLog<std::string> x;
+    AppendLog<std::string>::Reader r(x);
+    {
+    AppendLog<std::string>::View v = r.view();
+    ASSERT_TRUE(v.size() == 0);
+    ASSERT_TRUE(v.begin() == v.end());
+    }
+    for (int i = 0; i < 5000; ++i)
+        x.push_back(std::to_string(i));
+    ASSERT_TRUE((x.size() == 5000) && (x[4999] == "4999"));
+    AppendLog<std::string>::View v = r.view();
+    x.push_back("late");
+    ASSERT_TRUE(v.size() == 5000);
+    ASSERT_TRUE(v[1024] == "1024");
+    int i = 0;
+    for (AppendLog<std::string>::View::const_iterator p = v.begin(); p != v.end(); ++p, ++i)
+        ASSERT_TRUE(*p == std::to_string(i));
+    ASSERT_TRUE(i == 5000);
+}
+
+TEST (AppendLg, append_log_2) {
+    AppendLog<int> x;
+    const size_t b = AppendLog<int>::blockSize;
+    for (size_t i = 0; i < 16 * b; ++i)
+        x.push_back(int(i));
+    ASSERT_TRUE(x.retired() == 0);
+    {
+    AppendLog<int>::Reader r(x);
+    AppendLog<int>::View   v = r.view();
+    x.push_back(-1);
+    ASSERT_TRUE(x.retired() == 1);
+    for (size_t i = 0; i < 16 * b; ++i)
+        x.push_back(int(i));
+    ASSERT_TRUE(x.retired() == 2);
+    ASSERT_TRUE(v[16 * b - 1] == int(16 * b - 1));
+    }
+    for (size_t i = 0; i < 32 * b; ++i)
+        x.push_back(int(i));
+    ASSERT_TRUE(x.retired() == 0);
+    ASSERT_TRUE(x[16 * b] == -1);
+}
+
+TEST (AppendLg, append_log_3) {
+    AppendLog<size_t> x;
+    const size_t n = 200000;
+    std::atomic<bool> bad(false);
+    std::vector<std::thread> t;
+    for (int k = 0; k < 4; ++k)
+        t.push_back(std::thread([&x, &bad, n] {
+            AppendLog<size_t>::Reader r(x);
+            size_t seen = 0;
+            while (seen < n) {
+                AppendLog<size_t>::View v = r.view();
+                for (size_t i = seen; i < v.size(); ++i)
+                    if (v[i] != i)
+                        bad = true;
+                if (v.size() && (v[v.size() / 2] != v.size() / 2))
+                    bad = true;
+                seen = v.size();}}));
+    for (size_t i = 0; i < n; ++i)
+        x.push_back(i);
+    for (size_t k = 0; k < t.size(); ++k)
+        t[k].join();
+    ASSERT_FALSE(bad);
+}
+
+
+
+// *** INCREMENTAL GROWTH ***
+TEST (Incremental, incremental_1) {
+    MyDeque<int> x;
+    ASSERT_FALSE(x.incremental_growth());
+    x.incremental_growth(true);
+    ASSERT_TRUE(x.incremental_growth());
+    for (int i = 0; i < 200000; ++i) {
+        x.push_back(i);
+        if (i % 1000 == 0) {
+            ASSERT_TRUE((x[i / 2] == i / 2) && (x.back() == i));}}
+    int i = 0;
+    for (MyDeque<int>::iterator p = x.begin(); p != x.end(); ++p, ++i)
+        ASSERT_TRUE(*p == i);
+    x.incremental_growth(false);
+    ASSERT_TRUE(x.size() == 200000);
+    ASSERT_TRUE(x.at(199999) == 199999);
+}
+
+TEST (Incremental, incremental_2) {
+    MyDeque<int> x;
+    std::deque<int> y;
+    x.incremental_growth(true);
+    for (int i = 0; i < 300000; ++i) {
+        if (i % 3 == 2) {
+            x.pop_front();
+            y.pop_front();}
+        else if (i % 2) {
+            x.push_back(i);
+            y.push_back(i);}
+        else {
+            x.push_front(i);
+            y.push_front(i);}
+        if (i % 997 == 0) {
+            ASSERT_TRUE((x.size() == y.size()) && (x[x.size() / 3] == y[y.size() / 3]));}}
+    ASSERT_TRUE(std::equal(x.begin(), x.end(), y.begin()));
+    while (!y.empty()) {
+        ASSERT_TRUE(x.back() == y.back());
+        x.pop_back();
+        y.pop_back();}
+    ASSERT_TRUE(x.empty());
+}
+
+TEST (Incremental, incremental_3) {
+    MyDeque<int> x;
+    x.incremental_growth(true);
+    int n = 0;
+    for (int r = 0; r < 20; ++r) {
+        for (int i = 0; i < 3000 + 517 * r; ++i)
+            x.push_back(n++);
+        MyDeque<int> y = x.split_at(x.size() / 2);
+        MyDeque<int> z(y);
+        x.splice_back(std::move(y));
+        x.swap(z);
+        x.swap(z);
+        ASSERT_TRUE(x.size() == size_t(n));
+        x.insert(x.begin() + 7, -1);
+        x.erase(x.begin() + 7);}
+    for (int i = 0; i < n; i += 101)
+        ASSERT_TRUE(x[i] == i);
+    x.pop_front_n(n / 2);
+    ASSERT_TRUE(x.front() == n / 2);
+    x.clear();
+    x.push_front(1);
+    ASSERT_TRUE((x.size() == 1) && (x.back() == 1));
+}
+
+
+
+// *** OPERATION COUNTS ***
+// every public operation against bounds on what it may do to elements and the
+// allocator, MyDeque and std::deque alike, so an O(n) relocation or an extra
+// copy per push shows up as a failure rather than as a slow benchmark
+
+struct Counts {
+    size_t constructs;     // from an int or default
+    size_t copies;
+    size_t moves;          // constructions and assignments
+    size_t destroys;
+    size_t allocations;
+    size_t deallocations;
+    size_t live;           // bytes allocated and not yet given back
+    size_t peak;};         // most bytes live at once
+
+Counts counts;
+
+void reset_counts () {
+    const size_t live = counts.live;
+    counts      = Counts();
+    counts.live = live;
+    counts.peak = live;}
+
+struct Counted {
+    int v;
+
+    Counted (int v = 0) :
+            v (v) {
+        ++counts.constructs;}
+
+    Counted (const Counted& that) :
+            v (that.v) {
+        ++counts.copies;}
+
+    Counted (Counted&& that) :
+            v (that.v) {
+        ++counts.moves;}
+
+    Counted& operator = (const Counted& that) {
+        ++counts.copies;
+        v = that.v;
+        return *this;}
+
+    Counted& operator = (Counted&& that) {
+        ++counts.moves;
+        v = that.v;
+        return *this;}
+
+    ~Counted () {
+        ++counts.destroys;}};
+
+bool operator == (const Counted& lhs, const Counted& rhs) {
+    return lhs.v == rhs.v;}
+
+bool operator < (const Counted& lhs, const Counted& rhs) {
+    return lhs.v < rhs.v;}
+
+template <typename T>
+struct CountingAllocator {
+    typedef T value_type;
+
+    CountingAllocator ()
+        {}
+
+    template <typename U>
+    CountingAllocator (const CountingAllocator<U>&)
+        {}
+
+    T* allocate (size_t n) {
+        ++counts.allocations;
+        counts.live += n * sizeof(T);
+        counts.peak  = std::max(counts.peak, counts.live);
+        return std::allocator<T>().allocate(n);}
+
+    void deallocate (T* p, size_t n) {
+        ++counts.deallocations;
+        counts.live -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);}};
+
+template <typename T, typename U>
+bool operator == (const CountingAllocator<T>&, const CountingAllocator<U>&) {
+    return true;}
+
+typedef testing::Types<std::deque<Counted, CountingAllocator<Counted> >,
+                       MyDeque<Counted, CountingAllocator<Counted> > > CountedContainers;
+
+template <typename C>
+class Counting : public testing::Test {
+    protected:
+        static const int n = 10000;
+
+        // n elements, 0 to n - 1, pushed at the back
+        static void fill (C& x) {
+            for (int i = 0; i != n; ++i) {
+                const Counted v(i);
+                x.push_back(v);}}
+
+        void SetUp () {
+            reset_counts();}};
+
+TYPED_TEST_CASE(Counting, CountedContainers);
+
+TYPED_TEST (Counting, push) {
+    const int n = TestFixture::n;
+    {
+    TypeParam x;
+    reset_counts();
+    TestFixture::fill(x);
+    ASSERT_EQ(size_t(n), counts.copies);
+    ASSERT_EQ(0u, counts.moves);
+    ASSERT_EQ(size_t(n), counts.destroys);                       // just the temporaries
+    ASSERT_LE(counts.allocations, size_t(n / 32 + 16));          // a block per 32 or more, plus outer arrays
+    ASSERT_LE(counts.peak, 2 * n * sizeof(Counted) + 4096);
+    reset_counts();
+    for (int i = 0; i != n; ++i) {
+        const Counted v(-i);
+        x.push_front(v);}
+    ASSERT_EQ(size_t(n), counts.copies);
+    ASSERT_EQ(0u, counts.moves);
+    ASSERT_LE(counts.allocations, size_t(n / 32 + 16));
+    reset_counts();
+    }
+    ASSERT_EQ(size_t(2 * n), counts.destroys);
+    ASSERT_EQ(counts.allocations, 0u);
+    ASSERT_EQ(counts.live, 0u);
+}
+
+TYPED_TEST (Counting, pop) {
+    const int n = TestFixture::n;
+    TypeParam x;
+    TestFixture::fill(x);
+    TestFixture::fill(x);
+    reset_counts();
+    for (int i = 0; i != n; ++i)
+        x.pop_front();
+    for (int i = 0; i != n / 2; ++i)
+        x.pop_back();
+    ASSERT_EQ(size_t(n + n / 2), counts.destroys);
+    ASSERT_EQ(0u, counts.allocations);
+    ASSERT_EQ(0u, counts.copies + counts.moves);
+    reset_counts();
+    x.clear();
+    ASSERT_EQ(size_t(n / 2), counts.destroys);
+    ASSERT_EQ(0u, counts.allocations);
+}
+
+TYPED_TEST (Counting, access) {
+    const int n = TestFixture::n;
+    TypeParam x;
+    TestFixture::fill(x);
+    reset_counts();
+    long s = 0;
+    for (int i = 0; i != n; ++i)
+        s += x[i].v + x.at(i).v;
+    for (typename TypeParam::iterator p = x.begin(); p != x.end(); ++p)
+        s += p->v;
+    s += x.front().v + x.back().v;
+    ASSERT_EQ(long(3) * n * (n - 1) / 2 + (n - 1), s);
+    ASSERT_EQ(0u, counts.constructs + counts.copies + counts.moves + counts.destroys);
+    ASSERT_EQ(0u, counts.allocations + counts.deallocations);
+}
+
+TYPED_TEST (Counting, copy) {
+    const int n = TestFixture::n;
+    TypeParam x;
+    TestFixture::fill(x);
+    reset_counts();
+    TypeParam y(x);
+    ASSERT_EQ(size_t(n), counts.copies);
+    ASSERT_EQ(0u, counts.moves);
+    ASSERT_LE(counts.allocations, size_t(n / 32 + 16));
+    reset_counts();
+    y = x;                                                      // same size: assignments, no allocations
+    ASSERT_EQ(size_t(n), counts.copies);
+    ASSERT_EQ(0u, counts.allocations);
+    ASSERT_TRUE(x == y);
+}
+
+TYPED_TEST (Counting, move) {
+    const int n = TestFixture::n;
+    TypeParam x;
+    TestFixture::fill(x);
+    reset_counts();
+    TypeParam y(std::move(x));
+    TypeParam z;
+    z.swap(y);
+    y = std::move(z);
+    ASSERT_EQ(size_t(n), y.size());
+    ASSERT_EQ(0u, counts.copies + counts.moves + counts.destroys);
+    ASSERT_LE(counts.allocations, 4u);                           // std::deque allocates even when empty
+}
+
+TYPED_TEST (Counting, insert_erase) {
+    const int n = TestFixture::n;
+    TypeParam x;
+    TestFixture::fill(x);
+    reset_counts();
+    x.insert(x.begin() + n / 2, Counted(-1));
+    ASSERT_LE(counts.copies + counts.moves, size_t(n / 2 + 2));  // shifts one side at most
+    ASSERT_LE(counts.allocations, 2u);
+    reset_counts();
+    x.erase(x.begin() + n / 2);
+    ASSERT_LE(counts.copies + counts.moves, size_t(n / 2 + 2));
+    ASSERT_EQ(0u, counts.allocations);
+    ASSERT_EQ(size_t(n), x.size());
+    ASSERT_EQ(n / 2, x[n / 2].v);
+}
+
+TYPED_TEST (Counting, resize) {
+    const int n = TestFixture::n;
+    TypeParam x;
+    TestFixture::fill(x);
+    const Counted v(-1);
+    reset_counts();
+    x.resize(2 * n, v);
+    ASSERT_EQ(size_t(n), counts.copies);
+    ASSERT_EQ(0u, counts.moves);
+    ASSERT_LE(counts.allocations, size_t(n / 32 + 16));
+    reset_counts();
+    x.resize(n / 2, v);
+    ASSERT_EQ(size_t(3 * n / 2), counts.destroys);
+    ASSERT_EQ(0u, counts.copies + counts.moves + counts.allocations);
+    reset_counts();
+    x.clear();
+    ASSERT_EQ(size_t(n / 2), counts.destroys);
+    ASSERT_EQ(0u, counts.allocations);
+    ASSERT_LE(counts.live, 1024 + 2 * n / 32 * sizeof(void*));   // the inner arrays go back, the outer one stays
+}
+
+// operations only MyDeque has
+typedef MyDeque<Counted, CountingAllocator<Counted> > CountedDeque;
+
+CountedDeque counted (int b, int e) {
+    CountedDeque x;
+    for (int i = b; i != e; ++i) {
+        const Counted v(i);
+        x.push_back(v);}
+    return x;}
+
+TEST (Counting, pop_front_n) {
+    CountedDeque x = counted(0, 10000);
+    reset_counts();
+    x.pop_front_n(6000);
+    ASSERT_EQ(6000u, counts.destroys);
+    ASSERT_EQ(0u, counts.copies + counts.moves + counts.allocations);
+    ASSERT_EQ(6000, x.front().v);
+}
+
+TEST (Counting, sort) {
+    const size_t n = 10000;
+    CountedDeque x;
+    for (size_t i = 0; i != n; ++i) {
+        const Counted v(int((i * 7919) % n));
+        x.push_back(v);}
+    for (int stable = 0; stable != 2; ++stable) {
+        reset_counts();
+        if (stable)
+            x.stable_sort();
+        else
+            x.sort(std::greater<Counted>());
+        ASSERT_EQ(0u, counts.copies);
+        ASSERT_LE(counts.moves, 4 * n * 14);                    // O(n log n), log2(n) about 14
+        ASSERT_EQ(counts.allocations, 1u);                      // the scratch buffer, n / 16
+        ASSERT_LE(counts.peak - counts.live, n / 16 * sizeof(Counted));}
+    for (size_t i = 0; i != n; ++i)
+        ASSERT_EQ(int(i), x[i].v);
+}
+
+TEST (Counting, split_splice) {
+    const int n = 10000;
+    CountedDeque x = counted(0, n);
+    reset_counts();
+    CountedDeque y = x.split_at(n / 3);                         // moves one inner array at most
+    ASSERT_EQ(0u, counts.copies);
+    ASSERT_LE(counts.moves, CountedDeque::sizeArray);
+    ASSERT_LE(counts.allocations, 2u);
+    reset_counts();
+    x.splice_back(std::move(y));                                // and back, inner arrays relinked
+    ASSERT_EQ(0u, counts.copies);
+    ASSERT_LE(counts.moves, CountedDeque::sizeArray);
+    ASSERT_LE(counts.allocations, 1u);
+    ASSERT_TRUE(y.empty() && (x.size() == size_t(n)));
+    CountedDeque z = counted(0, 1000);
+    z.push_front(Counted(-1));                                  // so its inner arrays don't line up with x's
+    reset_counts();
+    x.splice_back(std::move(z));                                // the smaller side moved across
+    ASSERT_EQ(0u, counts.copies);
+    ASSERT_EQ(1001u, counts.moves);
+    ASSERT_LE(counts.allocations, size_t(1001 / 64 + 2));
+    z = counted(0, 20000);
+    reset_counts();
+    x.splice_front(std::move(z));                               // x is the smaller side now
+    ASSERT_EQ(0u, counts.copies);
+    ASSERT_EQ(size_t(n + 1001), counts.moves);
+    ASSERT_EQ(size_t(n + 1001), x.size() - 20000);
+    ASSERT_EQ(19999, x[19999].v);
+    ASSERT_EQ(0, x[20000].v);
+}
+
+TEST (Counting, incremental) {
+    const int n = 100000;
+    CountedDeque x;
+    x.incremental_growth(true);
+    reset_counts();
+    for (int i = 0; i != n; ++i) {
+        const Counted v(i);
+        x.push_back(v);
+        x.push_front(v);}
+    ASSERT_EQ(size_t(2 * n), counts.copies);
+    ASSERT_EQ(0u, counts.moves);
+    ASSERT_LE(counts.allocations, size_t(2 * n / 64 + 32));     // inner arrays, plus outer ones
+    ASSERT_LE(counts.peak, 2 * n * sizeof(Counted) + 2 * n / 64 * 6 * sizeof(Counted*) + 4096);  // old and new outer arrays
+    reset_counts();
+    for (int i = 0; i != n; ++i)
+        x.pop_front();
+    ASSERT_EQ(size_t(n), counts.destroys);
+    ASSERT_EQ(0u, counts.allocations);
+}
+
+
+
+// *** SHARDED QUEUE ***
+TEST (ShardedQ, sharded_queue_1) {
+    ShardedQueue<int> x(1);
+    ShardedQueue<int>::Local l(x);
+    int v = -1;
+    ASSERT_TRUE(!l.pop(v));
+    for (int i = 0; i < 100; ++i)
+        l.push(i);
+    ASSERT_TRUE(x.size() == 96);                                 // three batches flushed
+    l.flush();
+    ASSERT_TRUE(x.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(l.pop(v));
+        ASSERT_TRUE(v == i);}
+    ASSERT_TRUE(!l.pop(v));
+    ASSERT_TRUE(x.empty());
+}
+
+TEST (ShardedQ, sharded_queue_2) {
+    ShardedQueue<int> x(4);
+    ASSERT_TRUE(x.shards() == 4);
+    ShardedQueue<int>::Local p(x);
+    ShardedQueue<int>::Local c(x);
+    ASSERT_TRUE(p.home() == 0);
+    ASSERT_TRUE(c.home() == 1);
+    for (int i = 0; i < 1000; ++i)
+        p.push(i);
+    p.flush();
+    int v    = -1;
+    int last = -1;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(c.pop(v));                                  // stolen from p's shard, in order
+        ASSERT_TRUE(v > last);
+        last = v;}
+    {
+    ShardedQueue<int>::Local d(x);
+    ASSERT_TRUE(d.pop(v));
+    ASSERT_TRUE(v > last);
+    }
+    ASSERT_TRUE(x.size() + 10 + 1 <= 1000);
+    int n = 11;
+    while (p.pop(v))
+        ++n;
+    while (c.pop(v))
+        ++n;
+    ASSERT_TRUE(n == 1000);
+    ASSERT_TRUE(x.empty());
+}
+
+TEST (ShardedQ, sharded_queue_3) {
+    ShardedQueue<long> x(4);
+    const long n = 20000;
+    std::atomic<long> sum(0);
+    std::atomic<long> count(0);
+    std::atomic<int>  producing(4);
+    std::vector<std::thread> t;
+    for (int k = 0; k < 4; ++k)
+        t.push_back(std::thread([&x, &producing, k, n] {
+            ShardedQueue<long>::Local l(x);
+            for (long i = 0; i < n; ++i)
+                l.push(k * n + i);
+            l.flush();
+            --producing;}));
+    for (int k = 0; k < 4; ++k)
+        t.push_back(std::thread([&x, &sum, &count, &producing] {
+            ShardedQueue<long>::Local l(x);
+            long v;
+            while (true) {
+                if (l.pop(v)) {
+                    sum   += v;
+                    ++count;}
+                else if (producing == 0) {
+                    if (!l.pop(v))
+                        break;
+                    sum   += v;
+                    ++count;}}}));
+    for (size_t i = 0; i < t.size(); ++i)
+        t[i].join();
+    ASSERT_TRUE(x.empty());
+    ASSERT_TRUE(count == 4 * n);
+    ASSERT_TRUE(sum == 4 * n * (4 * n - 1) / 2);
+}
+
+TEST (ShardedQ, sharded_queue_4) {
+    ShardedQueue<std::unique_ptr<int> > x(1);
+    {
+    ShardedQueue<std::unique_ptr<int> >::Local l(x);
+    for (int i = 0; i < 40; ++i) {
+        std::unique_ptr<int> p(new int(i));
+        l.push(std::move(p));
+        ASSERT_TRUE(!p);}
+    std::unique_ptr<int> v;
+    ASSERT_TRUE(l.pop(v));                                      // takes a batch of 32
+    ASSERT_TRUE(*v == 0);
+    }                                                           // flushes 8, gives 31 back to the front
+    ASSERT_TRUE(x.size() == 39);
+    ShardedQueue<std::unique_ptr<int> >::Local l(x);
+    std::unique_ptr<int> v;
+    for (int i = 1; i < 40; ++i) {
+        ASSERT_TRUE(l.pop(v));
+        ASSERT_TRUE(*v == i);}
+    ASSERT_TRUE(!l.pop(v));
+}
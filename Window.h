@@ -0,0 +1,210 @@
+// -----------------------
+// projects/deque/Window.h
+// -----------------------
+
+#ifndef Window_h
+#define Window_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>    // assert
+#include <cstddef>    // size_t
+#include <functional> // greater, less, plus
+
+#include "Deque.h"
+
+// -----------
+// WindowEntry
+// -----------
+
+/**
+ a value in an AggregateWindow with its push number, its key (a timestamp, say)
+ and the fold of it and everything newer on the same stack
+ */
+template <typename T, typename K>
+struct WindowEntry {
+    std::size_t seq;
+    K           key;
+    T           value;
+    T           agg;};
+
+// ---------------
+// MonotonicWindow
+// ---------------
+
+/**
+ the best value, by C, of a sliding window in amortized O(1) per push
+ keeps only the values that can still become the best: each push pops the
+ values at the back it beats, so the deque runs from best to worst and its
+ front is the answer
+ evict with keep_last (count) or evict_before (key); keys must not decrease
+ MinWindow and MaxWindow are the usual instances
+ */
+template <typename T, typename C = std::less<T>, typename K = std::size_t>
+class MonotonicWindow {
+    private:
+        struct Entry {
+            std::size_t seq;
+            K           key;
+            T           value;};
+
+        MyDeque<Entry>                  _d;
+        C                               _c;
+        std::size_t                     _pushes;
+
+    public:
+        explicit MonotonicWindow (const C& c = C()) :
+                _c (c),
+                _pushes (0)
+            {}
+
+        /**
+         adds v at key k, newer than every value in the window
+         */
+        void push (const T& v, const K& k = K()) {
+            while (!_d.empty() && !_c(_d.back().value, v))
+                _d.pop_back();
+            Entry e = {_pushes++, k, v};
+            _d.push_back(e);}
+
+        /**
+         drops everything but the last n values pushed
+         */
+        void keep_last (std::size_t n) {
+            while (!_d.empty() && (_d.front().seq + n < _pushes))
+                _d.pop_front();}
+
+        /**
+         drops every value whose key is less than k
+         */
+        void evict_before (const K& k) {
+            while (!_d.empty() && (_d.front().key < k))
+                _d.pop_front();}
+
+        /**
+         returns the best value in the window
+         */
+        const T& top () const {
+            assert(!empty());
+            return _d.front().value;}
+
+        bool empty () const {
+            return _d.empty();}
+
+        void clear () {
+            _d.clear();}};
+
+template <typename T, typename K = std::size_t>
+class MinWindow : public MonotonicWindow<T, std::less<T>, K> {};
+
+template <typename T, typename K = std::size_t>
+class MaxWindow : public MonotonicWindow<T, std::greater<T>, K> {};
+
+// ---------------
+// AggregateWindow
+// ---------------
+
+/**
+ any associative Op (sum, min, gcd, matrix product, ...) over a sliding window
+ in amortized O(1) per push and pop, without needing an inverse
+ two stacks: new values go on the back one, which keeps a running aggregate;
+ when the front one runs out the back one is flipped into it, each entry
+ storing the aggregate of itself and everything newer on the front stack
+ Op needn't be commutative, the window is folded oldest to newest
+ */
+template <typename T, typename Op = std::plus<T>, typename K = std::size_t>
+class AggregateWindow {
+    private:
+        MyDeque< WindowEntry<T, K> >    _front;    // oldest first, agg = value op ... op newest on this stack
+        MyDeque< WindowEntry<T, K> >    _back;     // oldest first
+        T                               _backAgg;  // fold of _back, meaningless when it's empty
+        Op                              _op;
+        std::size_t                     _pushes;
+
+        void flip () {
+            assert(_front.empty());
+            while (!_back.empty()) {
+                WindowEntry<T, K> e = _back.back();
+                _back.pop_back();
+                e.agg = _front.empty() ? e.value : _op(e.value, _front.front().agg);
+                _front.push_front(e);}}
+
+        const WindowEntry<T, K>& oldest () const {
+            return _front.empty() ? _back.front() : _front.front();}
+
+    public:
+        explicit AggregateWindow (const Op& op = Op()) :
+                _backAgg (),
+                _op (op),
+                _pushes (0)
+            {}
+
+        /**
+         adds v at key k, newer than every value in the window
+         */
+        void push (const T& v, const K& k = K()) {
+            _backAgg = _back.empty() ? v : _op(_backAgg, v);
+            WindowEntry<T, K> e = {_pushes++, k, v, v};
+            _back.push_back(e);}
+
+        /**
+         drops the oldest value
+         */
+        void pop () {
+            assert(!empty());
+            if (_front.empty())
+                flip();
+            _front.pop_front();}
+
+        /**
+         drops everything but the last n values pushed
+         */
+        void keep_last (std::size_t n) {
+            while (size() > n)
+                pop();}
+
+        /**
+         drops every value whose key is less than k
+         */
+        void evict_before (const K& k) {
+            while (!empty() && (oldest().key < k))
+                pop();}
+
+        /**
+         returns the fold of the window, oldest to newest, by Op
+         */
+        T value () const {
+            assert(!empty());
+            if (_front.empty())
+                return _backAgg;
+            if (_back.empty())
+                return _front.front().agg;
+            return _op(_front.front().agg, _backAgg);}
+
+        /**
+         returns the mean of the window, value() / size(), which is what it is
+         only when Op is plus
+         */
+        T mean () const {
+            return value() / T(size());}
+
+        /**
+         returns the oldest value in the window
+         */
+        const T& front () const {
+            assert(!empty());
+            return oldest().value;}
+
+        std::size_t size () const {
+            return _front.size() + _back.size();}
+
+        bool empty () const {
+            return size() == 0;}
+
+        void clear () {
+            _front.clear();
+            _back.clear();}};
+
+#endif // Window_h
@@ -5,6 +5,9 @@ clean:
 	rm -f Deque.log
 	rm -f Deque.zip
 	rm -f TestDeque
+	rm -f TestDequeDebug
+	rm -f BenchDeque
+	rm -f ReplayDeque
 
 doc: Deque.h
 	doxygen Doxyfile
@@ -21,11 +24,20 @@ turnin-verify:
 Deque.log:
 	git log > Deque.log
 
-Deque.zip: Deque.h Deque.log TestDeque.c++ TestDeque.out
-	zip -r Deque.zip html/ Deque.h Deque.log TestDeque.c++ TestDeque.out
+Deque.zip: Deque.h AppendLog.h AsyncDeque.h DequeTrace.h BlockAllocator.h Channel.h CompressedDeque.h RecordDeque.h ShardedQueue.h SoADeque.h Window.h HandleDeque.h ExpiryQueue.h Deque.log TestDeque.c++ TestDeque.out
+	zip -r Deque.zip html/ Deque.h AppendLog.h AsyncDeque.h DequeTrace.h BlockAllocator.h Channel.h CompressedDeque.h RecordDeque.h ShardedQueue.h SoADeque.h Window.h HandleDeque.h ExpiryQueue.h Deque.log TestDeque.c++ TestDeque.out
 
-TestDeque: Deque.h TestDeque.c++
-	g++ -pedantic -std=c++0x -Wall TestDeque.c++ -o TestDeque -lcppunit -ldl
+TestDeque: Deque.h AppendLog.h AsyncDeque.h DequeTrace.h BlockAllocator.h Channel.h CompressedDeque.h RecordDeque.h ShardedQueue.h SoADeque.h Window.h HandleDeque.h ExpiryQueue.h TestDeque.c++
+	g++ -pedantic -std=c++20 -Wall -DDEQUE_TRACE TestDeque.c++ -o TestDeque -lgtest -lgtest_main -lpthread
+
+TestDequeDebug: Deque.h AppendLog.h AsyncDeque.h DequeTrace.h BlockAllocator.h Channel.h CompressedDeque.h RecordDeque.h ShardedQueue.h SoADeque.h Window.h HandleDeque.h ExpiryQueue.h TestDeque.c++
+	g++ -pedantic -std=c++20 -Wall -DDEQUE_TRACE -DDEQUE_DEBUG TestDeque.c++ -o TestDequeDebug -lgtest -lgtest_main -lpthread
+
+BenchDeque: Deque.h AppendLog.h AsyncDeque.h DequeTrace.h BlockAllocator.h Channel.h CompressedDeque.h RecordDeque.h ShardedQueue.h SoADeque.h Window.h HandleDeque.h ExpiryQueue.h BenchDeque.c++
+	g++ -pedantic -std=c++20 -Wall -O2 -DNDEBUG BenchDeque.c++ -o BenchDeque -lpthread
+
+ReplayDeque: Deque.h DequeTrace.h ReplayDeque.c++
+	g++ -pedantic -std=c++20 -Wall -O2 -DNDEBUG ReplayDeque.c++ -o ReplayDeque
 
 TestDeque.out: TestDeque
 	valgrind TestDeque > TestDeque.out